@@ -0,0 +1,199 @@
+// engine micro benchmarks
+// every config in Config.h is run through the same worst-case-ish pattern
+// (all steps of all tracks enabled, full polyphony) with a counting MIDI sink,
+// so only the sequencer logic itself is measured
+// the pattern length sweep checks that neither the tick cost nor the time to
+// load a plugin instance grows with the number of steps
+// the size report compares the default and the compact (E3SEQ_COMPACT_STEPS)
+// step format, whichever of the two this build runs on
+
+#include "E3Seq/E3Sequencer.h"
+#include "E3Seq/PluginProcessor.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+struct Result {
+  long long numTicks = 0;
+  long long numEvents = 0;
+  double elapsedSeconds = 0.0;
+  double musicSeconds = 0.0;
+  std::size_t stepMemory = 0;
+};
+
+void print(const char* name, const Result& result) {
+  std::cout << std::left << std::setw(28) << name << std::right
+            << std::setw(10) << result.numTicks << " ticks "
+            << std::setw(10) << result.numEvents << " events "
+            << std::setw(9) << std::fixed << std::setprecision(1)
+            << result.elapsedSeconds * 1e9 / result.numTicks << " ns/tick "
+            << std::setw(10) << std::setprecision(0)
+            << result.musicSeconds / result.elapsedSeconds << "x real time "
+            << std::setw(6) << result.stepMemory / 1024 << " KiB steps"
+            << std::endl;
+}
+
+template <typename Config>
+void programFullPattern(Sequencer::BasicE3Sequencer<Config>& sequencer,
+                        int length) {
+  for (int t = 0; t < Config::numMonoTracks; ++t) {
+    auto& track = sequencer.getMonoTrack(t);
+    track.setLength(length);
+    for (int i = 0; i < length; ++i) {
+      typename Sequencer::BasicE3Sequencer<Config>::MonoStep step;
+      step.enabled = true;
+      step.note.number = 36 + (i * 7 + t) % 48;
+      step.probability = 0.75f;
+      step.retrigger_ticks = (i % 4 == 3) ? Config::ticksPerStep / 4 : 0;
+      track.setStepAtIndex(i, step);
+    }
+  }
+
+  for (int t = 0; t < Config::numPolyTracks; ++t) {
+    auto& track = sequencer.getPolyTrack(t);
+    track.setLength(length);
+    for (int i = 0; i < length; ++i) {
+      typename Sequencer::BasicE3Sequencer<Config>::PolyStep step;
+      step.enabled = true;
+      for (int n = 0; n < Config::polyphony; ++n) {
+        step.notes[n].number = 48 + (i + n * 4) % 36;
+        step.notes[n].offset_ticks =
+            (n % 2 == 0) ? 0 : Config::offsetToTicks(-0.25f);
+      }
+      track.setStepAtIndex(i, step);
+    }
+  }
+}
+
+// MARK: tick throughput
+template <typename Config>
+Result benchmarkTicks(int length, int numLoops) {
+  juce::MidiMessageCollector collector;
+  collector.reset(44100.0);
+  Sequencer::BasicE3Sequencer<Config> sequencer(collector);
+
+  Result result;
+  for (int channel = 1; channel <= Config::numTracks; ++channel) {
+    sequencer.getTrackByChannel(channel).sendMidiMessage =
+        [&result](juce::MidiMessage) { ++result.numEvents; };
+  }
+
+  programFullPattern(sequencer, length);
+  sequencer.start(0.0);
+
+  result.numTicks =
+      static_cast<long long>(numLoops) * length * Config::ticksPerStep;
+
+  auto start = std::chrono::steady_clock::now();
+  for (long long i = 0; i < result.numTicks; ++i) {
+    sequencer.tick();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  result.elapsedSeconds = std::chrono::duration<double>(end - start).count();
+  result.musicSeconds = result.numTicks * sequencer.getOneTickTime();
+  for (int t = 0; t < Config::numMonoTracks; ++t) {
+    result.stepMemory += sequencer.getMonoTrack(t).getStepMemoryUsage();
+  }
+  for (int t = 0; t < Config::numPolyTracks; ++t) {
+    result.stepMemory += sequencer.getPolyTrack(t).getStepMemoryUsage();
+  }
+  return result;
+}
+
+// MARK: instance load
+// what a host does when it opens a project: construct the plugin and restore
+// a state with {length} steps in use on every track
+void benchmarkInstanceLoad(int length) {
+  juce::MemoryBlock state;
+  {
+    audio_plugin::AudioPluginAudioProcessor source;
+    for (int t = 0; t < STEP_SEQ_NUM_TRACKS; ++t) {
+      auto* p = source.parameters.getParameter("T" + juce::String(t) +
+                                               "_TRACK_LENGTH");
+      p->setValueNotifyingHost(p->convertTo0to1(static_cast<float>(length)));
+    }
+    programFullPattern(source.sequencer, length);
+    source.getStateInformation(state);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  audio_plugin::AudioPluginAudioProcessor instance;
+  instance.setStateInformation(state.getData(),
+                               static_cast<int>(state.getSize()));
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout << std::left << std::setw(28)
+            << ("load " + std::to_string(length) + " steps") << std::right
+            << std::setw(9) << std::fixed << std::setprecision(2)
+            << std::chrono::duration<double, std::milli>(end - start).count()
+            << " ms " << std::setw(6) << instance.getParameters().size()
+            << " parameters " << std::setw(8) << state.getSize() / 1024
+            << " KiB state" << std::endl;
+}
+
+// MARK: size report
+// step storage of one track (pages and render schedule) and of all tracks of
+// an instance, for a {length} step pattern
+template <bool Compact>
+void printStepStorageSize(const char* name, int length) {
+  using Config = Sequencer::DefaultConfig;
+  using MonoPage =
+      Sequencer::StepColumns<Sequencer::MonoStep, Config::pageLength, Compact>;
+  using PolyPage =
+      Sequencer::StepColumns<Sequencer::PolyStep, Config::pageLength, Compact>;
+  using Tick = typename Sequencer::StepFormat<Config, Compact>::Tick;
+
+  std::size_t pages = static_cast<std::size_t>(
+      (length + Config::pageLength - 1) / Config::pageLength);
+  std::size_t schedule = Config::maxLength * sizeof(Tick);
+  std::size_t mono = pages * sizeof(MonoPage) + schedule;
+  std::size_t poly = pages * sizeof(PolyPage) + schedule;
+  std::size_t instance =
+      Config::numMonoTracks * mono + Config::numPolyTracks * poly;
+
+  std::cout << std::left << std::setw(28)
+            << (std::string(name) + " " + std::to_string(length) + " steps")
+            << std::right << std::setw(8) << mono << " B/mono track "
+            << std::setw(8) << poly << " B/poly track " << std::setw(8)
+            << instance << " B/instance" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+  std::cout << "step storage (running on the "
+            << (E3SEQ_COMPACT_STEPS ? "compact" : "default") << " format)"
+            << std::endl;
+  for (int length : {16, STEP_SEQ_MAX_LENGTH}) {
+    printStepStorageSize<false>("default", length);
+    printStepStorageSize<true>("compact", length);
+  }
+  std::cout << std::endl;
+
+  std::cout << "tick throughput (all steps enabled, 12 tracks)" << std::endl;
+  print("embedded 96ppq/16 steps",
+        benchmarkTicks<Sequencer::EmbeddedConfig>(16, 200));
+  print("default (plugin)",
+        benchmarkTicks<Sequencer::DefaultConfig>(
+            Sequencer::DefaultConfig::defaultLength, 200));
+  print("desktop 960ppq/128 steps",
+        benchmarkTicks<Sequencer::DesktopConfig>(128, 5));
+
+  // same number of ticks for every length, so the columns compare directly
+  std::cout << std::endl << "pattern length (plugin config)" << std::endl;
+  for (int length = 16; length <= STEP_SEQ_MAX_LENGTH; length *= 2) {
+    print(("default " + std::to_string(length) + " steps").c_str(),
+          benchmarkTicks<Sequencer::DefaultConfig>(length, 4096 / length));
+  }
+
+  juce::ScopedJuceInitialiser_GUI juce_initialiser;
+  std::cout << std::endl << "instance load" << std::endl;
+  for (int length = 16; length <= STEP_SEQ_MAX_LENGTH; length *= 2) {
+    benchmarkInstanceLoad(length);
+  }
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "E3Seq/OfflineRenderer.h"
+
+/*
+  renders a whole folder of presets to MIDI files using every core
+
+  each preset is an independent job on a juce::ThreadPool, idle workers simply
+  pick up the next pending preset so long and short patterns balance out on
+  their own. every job owns its OfflineRenderer, nothing is shared between
+  threads except the (pre-sized) result slots
+*/
+
+namespace Sequencer {
+
+class BatchRenderer {
+public:
+  struct Options {
+    int seedsPerPreset = 1;
+    int numLoops = 1;
+    juce::int64 baseSeed = 0;
+    double bpm = BPM_DEFAULT;
+    int numThreads = 0;  // 0 means one per CPU core
+  };
+
+  struct Report {
+    int numPresets = 0;
+    int numFilesWritten = 0;
+    juce::int64 numEvents = 0;
+    double elapsedSeconds = 0.0;
+    juce::StringArray failures;  // "<file>: <reason>"
+
+    double getPresetsPerSecond() const {
+      return elapsedSeconds > 0.0 ? numPresets / elapsedSeconds : 0.0;
+    }
+    double getEventsPerSecond() const {
+      return elapsedSeconds > 0.0 ? numEvents / elapsedSeconds : 0.0;
+    }
+  };
+
+  // accepts both the XML written by savePreset() and the binary blob written
+  // by getStateInformation(), returns nullptr if it is neither
+  static std::unique_ptr<juce::XmlElement> readPreset(const juce::File& file);
+
+  // renders every preset in {presetFolder} {seedsPerPreset} times into
+  // {outputFolder} as <preset name>_seed<n>.mid
+  static Report run(const juce::File& presetFolder,
+                    const juce::File& outputFolder,
+                    const Options& options);
+};
+
+}  // namespace Sequencer
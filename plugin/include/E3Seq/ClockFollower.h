@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <numbers>
+
+/*
+  follows an external MIDI clock (24 pulses per quarter note)
+
+  the pulse times go through a second order delay-locked loop (after F.
+  Adriaensen, "Using a DLL to filter time"): it predicts the time of the next
+  pulse and corrects both the prediction and its period estimate by the
+  prediction error. the jitter of single pulses is averaged out over roughly
+  1/{bandwidth} seconds, and tempo changes are followed at the same rate
+
+  the loop counts as locked once the phase error stayed within
+  LOCK_TOLERANCE of a period for a whole quarter note, getLockTime() tells
+  how long that took from the first pulse
+
+  pulse() is called from the thread that receives MIDI, the getters may be
+  called from any other thread
+*/
+
+namespace Sequencer {
+
+class ClockFollower {
+public:
+  static constexpr int PULSES_PER_QUARTER = 24;
+  static constexpr double LOCK_TOLERANCE = 0.1;
+  // a gap of this many periods means the clock stopped, start over
+  static constexpr double DROPOUT_PERIODS = 4.0;
+
+  explicit ClockFollower(double bandwidth = 1.0) : bandwidth_(bandwidth) {}
+
+  void reset() {
+    numPulses_ = 0;
+    lockCount_ = 0;
+    period_.store(0.0);
+    phaseError_.store(0.0);
+    lockTime_.store(-1.0);
+    locked_.store(false);
+  }
+
+  // {time} of the pulse in seconds
+  void pulse(double time) {
+    double period = period_.load(std::memory_order_relaxed);
+    if (numPulses_ >= 2 && time - predicted_ > DROPOUT_PERIODS * period) {
+      reset();
+    }
+
+    ++numPulses_;
+    if (numPulses_ == 1) {
+      firstPulse_ = time;
+      pulseTime_.store(time);
+      return;
+    }
+    if (numPulses_ == 2) {
+      period = time - pulseTime_.load(std::memory_order_relaxed);
+      period_.store(period);
+      pulseTime_.store(time);
+      predicted_ = time + period;
+      return;
+    }
+
+    double error = time - predicted_;
+    double omega = 2.0 * std::numbers::pi * bandwidth_ * period;
+    pulseTime_.store(predicted_);
+    predicted_ += std::numbers::sqrt2 * omega * error + period;
+    period_.store(period + omega * omega * error);
+    phaseError_.store(error);
+
+    if (std::abs(error) <= LOCK_TOLERANCE * period) {
+      if (++lockCount_ == PULSES_PER_QUARTER && !locked_.load()) {
+        lockTime_.store(time - firstPulse_);
+        locked_.store(true);
+      }
+    } else {
+      lockCount_ = 0;
+      locked_.store(false);
+    }
+  }
+
+  // seconds between pulses, 0 before the second pulse
+  double getPeriod() const { return period_.load(); }
+
+  double getBpm() const {
+    double period = getPeriod();
+    return period > 0.0 ? 60.0 / (period * PULSES_PER_QUARTER) : 0.0;
+  }
+
+  // filtered time of the latest pulse
+  double getPulseTime() const { return pulseTime_.load(); }
+
+  // latest pulse minus its prediction, in seconds
+  double getPhaseError() const { return phaseError_.load(); }
+
+  bool isLocked() const { return locked_.load(); }
+
+  // seconds from the first pulse until the loop locked, -1 if it never did
+  double getLockTime() const { return lockTime_.load(); }
+
+private:
+  const double bandwidth_;
+
+  // only touched by pulse()
+  int numPulses_ = 0;
+  int lockCount_ = 0;
+  double firstPulse_ = 0.0;
+  double predicted_ = 0.0;
+
+  std::atomic<double> period_{0.0};
+  std::atomic<double> pulseTime_{0.0};
+  std::atomic<double> phaseError_{0.0};
+  std::atomic<double> lockTime_{-1.0};
+  std::atomic<bool> locked_{false};
+};
+
+}  // namespace Sequencer
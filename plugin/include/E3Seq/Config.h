@@ -0,0 +1,128 @@
+#pragma once
+
+/*
+  compile-time geometry of the sequencer engine
+
+  Track, MonoTrack, PolyTrack and E3Sequencer are templates on one of the
+  config structs below, so every loop bound and array size in the engine is
+  known at compile time. the plugin uses DefaultConfig, whose values are the
+  macros below (they are also used by the processor and the GUI)
+*/
+
+#define STEP_SEQ_MAX_LENGTH 256
+#define STEP_SEQ_DEFAULT_LENGTH 16
+// steps are stored, exposed to the host and edited one page at a time
+#define STEP_SEQ_PAGE_LENGTH 16
+#define STEP_SEQ_NUM_PAGES \
+  ((STEP_SEQ_MAX_LENGTH + STEP_SEQ_PAGE_LENGTH - 1) / STEP_SEQ_PAGE_LENGTH)
+#define TICKS_PER_STEP 24  // one step is broken into {TICKS_PER_STEP} ticks
+// note: TICKS_PER_STEP over 24 (96 ppq) makes little sense since tick() need to
+// be called more frequently than 1kHz to achieve such precision
+
+#define POLYPHONY 4
+
+// store steps in narrow (byte sized) fields, see StepFormat.h
+// set by the E3SEQ_COMPACT_STEPS CMake option
+#ifndef E3SEQ_COMPACT_STEPS
+#define E3SEQ_COMPACT_STEPS 0
+#endif
+
+#define STEP_SEQ_NUM_MONO_TRACKS 8
+#define STEP_SEQ_NUM_POLY_TRACKS 4
+#define STEP_SEQ_NUM_TRACKS \
+  (STEP_SEQ_NUM_MONO_TRACKS + STEP_SEQ_NUM_POLY_TRACKS)
+
+namespace Sequencer {
+
+template <int TicksPerStep,
+          int MaxLength,
+          int Polyphony,
+          int NumMonoTracks,
+          int NumPolyTracks>
+struct SequencerConfig {
+  static constexpr int ticksPerStep = TicksPerStep;
+  static constexpr int maxLength = MaxLength;
+  static constexpr int defaultLength =
+      MaxLength < STEP_SEQ_DEFAULT_LENGTH ? MaxLength : STEP_SEQ_DEFAULT_LENGTH;
+  static constexpr int pageLength =
+      MaxLength < STEP_SEQ_PAGE_LENGTH ? MaxLength : STEP_SEQ_PAGE_LENGTH;
+  static constexpr int polyphony = Polyphony;
+  static constexpr int numMonoTracks = NumMonoTracks;
+  static constexpr int numPolyTracks = NumPolyTracks;
+  static constexpr int numTracks = NumMonoTracks + NumPolyTracks;
+
+  static_assert(TicksPerStep % 2 == 0,
+                "half a step must be a whole number of ticks");
+  static_assert(MaxLength > 0 && Polyphony > 0);
+  static_assert(numTracks <= 16, "one MIDI channel per track");
+
+  // micro-timing is stored in ticks, the float step values below only exist
+  // at the parameter/GUI boundary and are converted once when a step is set
+
+  // rounds to the nearest tick (retrigger rate, generic durations)
+  static constexpr int stepsToTicks(float steps) {
+    float ticks = steps * TicksPerStep;
+    return static_cast<int>(ticks >= 0.f ? ticks + 0.5f : ticks - 0.5f);
+  }
+
+  // floors, so an offset in [-0.5, 0.5) always lands in
+  // [-ticksPerStep / 2, ticksPerStep / 2) and stays inside its own step
+  // (this is also the same rounding for every step index, including 0)
+  static constexpr int offsetToTicks(float offset) {
+    // (the epsilon keeps values that are a tick minus rounding error, e.g.
+    // 1/24 * 24, on that tick)
+    float ticks = offset * TicksPerStep + 1e-3f;
+    int truncated = static_cast<int>(ticks);
+    int floored = ticks < truncated ? truncated - 1 : truncated;
+    if (floored < -TicksPerStep / 2)
+      return -TicksPerStep / 2;
+    if (floored >= TicksPerStep / 2)
+      return TicksPerStep / 2 - 1;
+    return floored;
+  }
+
+  // a note is at least one tick and at most one full loop long
+  static constexpr int lengthToTicks(float length) {
+    int ticks = stepsToTicks(length);
+    if (ticks < 1)
+      return 1;
+    if (ticks > MaxLength * TicksPerStep)
+      return MaxLength * TicksPerStep;
+    return ticks;
+  }
+
+  // swing is the share of a pair of steps taken by the first one (0.5 is
+  // straight), the second one is delayed by the rest, at most half a step
+  // (0.75, a dotted rhythm)
+  static constexpr int swingToTicks(float swing) {
+    int ticks = stepsToTicks(2.f * swing - 1.f);
+    if (ticks < 0)
+      return 0;
+    if (ticks > TicksPerStep / 2)
+      return TicksPerStep / 2;
+    return ticks;
+  }
+
+  static constexpr float ticksToSteps(int ticks) {
+    return static_cast<float>(ticks) / TicksPerStep;
+  }
+};
+
+// note: these are distinct structs rather than aliases so that two configs
+// with the same numbers are still different engine types
+
+// what the plugin runs
+struct DefaultConfig : SequencerConfig<TICKS_PER_STEP,
+                                       STEP_SEQ_MAX_LENGTH,
+                                       POLYPHONY,
+                                       STEP_SEQ_NUM_MONO_TRACKS,
+                                       STEP_SEQ_NUM_POLY_TRACKS> {};
+
+// 96 ppq, 16 steps, for small hardware targets (Spark/Prologue)
+struct EmbeddedConfig : SequencerConfig<24, 16, 4, 8, 4> {};
+
+// 960 ppq, 128 steps, for desktop and offline rendering
+// (the plugin itself goes up to {STEP_SEQ_MAX_LENGTH} steps at 96 ppq)
+struct DesktopConfig : SequencerConfig<240, 128, 4, 8, 4> {};
+
+}  // namespace Sequencer
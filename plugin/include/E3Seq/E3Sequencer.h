@@ -10,19 +10,36 @@
 #include "E3Seq/MonoTrack.h"
 #include "E3Seq/PolyTrack.h"
 #include "E3Seq/KeyboardMonitor.h"
+#include "E3Seq/ClockFollower.h"
+#include "E3Seq/TempoMap.h"
+#include "E3Seq/SeqLock.h"
+#include "E3Seq/Fifo.h"
+#include "E3Seq/SharedClock.h"
+#include "E3Seq/OutputQueue.h"
 #include <juce_audio_devices/juce_audio_devices.h>  // juce::MidiMessageCollector
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <utility>  // std::index_sequence
 
 // TODO: Doxygen documentation
 // TODO: add example code
 
-#define STEP_SEQ_NUM_MONO_TRACKS 8
-#define STEP_SEQ_NUM_POLY_TRACKS 4
-#define STEP_SEQ_NUM_TRACKS \
-  (STEP_SEQ_NUM_MONO_TRACKS + STEP_SEQ_NUM_POLY_TRACKS)
 #define BPM_DEFAULT 120
 #define BPM_MAX 240
 #define BPM_MIN 30
 
+// steps are rendered this many steps before they play, and their events are
+// sent up to a quarter step early (see Track::setLookahead())
+#define LOOKAHEAD_STEPS_DEFAULT 1
+#define LOOKAHEAD_STEPS_MAX 4
+
+// tracks synced to the master loop start over this often (see
+// setMasterLength()), at least a beat so a track at its slowest still has a
+// whole step in it
+#define MASTER_LENGTH_MIN 4
+
 /*
   by default, the timing resolution is a 1/384 of one bar
   (or 1/24 of a quarter note, same as Elektron)
@@ -34,32 +51,151 @@
 
 namespace Sequencer {
 
-class E3Sequencer {
+// see Config.h for the available configs, the plugin uses E3Sequencer
+template <typename Config>
+class BasicE3Sequencer {
 public:
-  E3Sequencer(juce::MidiMessageCollector& midiCollector,
-              double bpm = BPM_DEFAULT);
+  using Track = BasicTrack<Config>;
+  using MonoTrack = BasicMonoTrack<Config>;
+  using PolyTrack = BasicPolyTrack<Config>;
+  using MonoStep = typename MonoTrack::Step;
+  using PolyStep = typename PolyTrack::Step;
+  using Note = typename Track::Note;
+
+  static constexpr int numMonoTracks = Config::numMonoTracks;
+  static constexpr int numPolyTracks = Config::numPolyTracks;
+  static constexpr int numTracks = Config::numTracks;
+  // ticks per MIDI clock pulse (a step is a 16th note)
+  static constexpr int ticksPerClock =
+      Config::ticksPerStep * 4 / ClockFollower::PULSES_PER_QUARTER;
+  static_assert(ticksPerClock * ClockFollower::PULSES_PER_QUARTER ==
+                    Config::ticksPerStep * 4,
+                "a MIDI clock pulse must be a whole number of ticks");
 
-  E3Sequencer(const E3Sequencer&) = delete;
-  E3Sequencer& operator=(const E3Sequencer&) = delete;
-  ~E3Sequencer() = default;
+  BasicE3Sequencer(juce::MidiMessageCollector& midiCollector,
+                   double bpm = BPM_DEFAULT);
+
+  BasicE3Sequencer(const BasicE3Sequencer&) = delete;
+  BasicE3Sequencer& operator=(const BasicE3Sequencer&) = delete;
+  ~BasicE3Sequencer() = default;
 
   void start(double startTime);
 
   void stop() {
+    if (running_) {
+      sendClock(juce::MidiMessage::midiStop());
+    }
     running_ = false;
+    positionMoved_.store(true);
     panic();
   }
 
+  // back to the first step without playing, resume() plays from there
+  void rewind();
+
+  // moves the play position to {tick} (ticks since the first step) without
+  // playing what is in between, see Track::locate()
+  void locate(juce::int64 tick);
+
   bool neverStarted() const { return startTime_ == 0.0; }
 
-  void resume() { running_ = true; }
-  void setBpm(double BPM) { bpm_ = BPM; }
-  double getBpm() const { return bpm_; }
+  void resume() {
+    if (!running_) {
+      // the next tick plays now, so the time stamps (and the continue
+      // message) are not left behind by the pause
+      startTime_ = juce::Time::getMillisecondCounterHiRes() * 0.001 -
+                   tempo_.getTime(static_cast<double>(clockTick_));
+      positionMoved_.store(true);
+      sendClock(juce::MidiMessage::midiContinue());
+    }
+    running_ = true;
+  }
+
+  // the tempo changes at the next tick, or ramps there linearly over
+  // {rampSteps} steps. ticks already played keep their time (see
+  // TempoMap.h). may be called from any thread (the editor, the host sync
+  // and the clock followers all do)
+  void setBpm(double BPM, double rampSteps = 0.0) {
+    requestedTempo_.store(TempoRequest{static_cast<float>(BPM),
+                                       static_cast<float>(rampSteps)});
+  }
+  // the tempo last set (getOneTickTime() follows the tempo being played)
+  double getBpm() const { return requestedTempo_.load().bpm; }
+
+  // in steps, 0 renders every step at the last moment
+  void setLookahead(int steps) {
+    steps = std::clamp(steps, 0, LOOKAHEAD_STEPS_MAX);
+    for (int channel = 1; channel <= numTracks; ++channel) {
+      getTrackByChannel(channel).setLookahead(steps * Config::ticksPerStep);
+    }
+  }
+
+  // tracks synced to the master loop (see Track::setSyncMode()) start their
+  // loop over every {steps} steps
+  void setMasterLength(int steps) {
+    steps = std::clamp(steps, MASTER_LENGTH_MIN, Config::maxLength);
+    for (int channel = 1; channel <= numTracks; ++channel) {
+      getTrackByChannel(channel).setMasterLoop(steps * Config::ticksPerStep);
+    }
+  }
+
+  // output latency compensation of the device behind each track, in ms
+  // (positive: the track plays later, negative: earlier)
+  // applied at the next tick, may be called from another thread than
+  // process()
+  void setTrackDelay(int channel, double delayMs) {
+    if (trackDelaysMs_[channel - 1].exchange(delayMs) != delayMs) {
+      delaysChanged_.store(true);
+    }
+  }
+  double getTrackDelay(int channel) const {
+    return trackDelaysMs_[channel - 1].load();
+  }
+
+  // swing from 0.5 (straight) to 0.75 (see Config::swingToTicks()), every
+  // track swings by the global amount plus its own, at most half a step
+  void setSwing(float swing) {
+    int ticks = Config::swingToTicks(swing);
+    if (ticks != swingTicks_) {
+      swingTicks_ = ticks;
+      updateTrackSwings();
+    }
+  }
+  void setTrackSwing(int channel, float swing) {
+    int ticks = Config::swingToTicks(swing);
+    if (ticks != trackSwingTicks_[channel - 1]) {
+      trackSwingTicks_[channel - 1] = ticks;
+      updateTrackSwings();
+    }
+  }
+
+  // with a host that compensates plugin latency, every track is delayed by
+  // the largest negative delay and getLatency() reports that to the host, so
+  // no track has to play early. without one, negative delays send events
+  // early (see Track::setDelay()). applied at the next tick, like the
+  // track delays
+  void setHostCompensatesLatency(bool compensates) {
+    if (hostCompensatesLatency_.exchange(compensates) != compensates) {
+      delaysChanged_.store(true);
+    }
+  }
+
+  // in seconds
+  double getLatency() const {
+    if (!hostCompensatesLatency_.load())
+      return 0.0;
+    double earliest = 0.0;
+    for (const auto& delay : trackDelaysMs_) {
+      earliest = std::min(earliest, delay.load());
+    }
+    return -earliest * 0.001;
+  }
 
   // send allNoteOff to all tracks immediately
   // note: this is probably not the right way to do it, will refactor later
   void panic() {
-    for (int i = 0; i < STEP_SEQ_NUM_TRACKS; ++i) {
+    outbox_.drop();
+    for (int i = 0; i < numTracks; ++i) {
       auto msg = juce::MidiMessage::allNotesOff(i + 1);
       msg.setTimeStamp(juce::Time::getMillisecondCounterHiRes() * 0.001);
       midiCollector_.addMessageToQueue(msg);
@@ -78,14 +214,32 @@ public:
 
   void setArmed(bool armed) { armed_ = armed; }
   void setQuantizeRec(bool shouldQuantize) { quantizeRec_ = shouldQuantize; }
+  // recording input, stamped with the (fractional) tick at which it was
+  // played, see getTickAtTime()
+  // called on the audio thread: the notes are only queued, process() merges
+  // them into the steps between two ticks
   void handleNoteOn(juce::MidiMessage noteOn);
   void handleNoteOff(juce::MidiMessage noteOff);
 
+  // the tick playing at {time} (seconds, same clock as start()), from the
+  // latest tick played. from one thread at a time, other than process()'s
+  // (the audio thread): a position being published right now is not waited
+  // for, the one read before is used
+  double getTickAtTime(double time) const {
+    PlayPosition position;
+    unsigned version;
+    if (position_.load(position, version)) {
+      lastPosition_ = position;
+    }
+    return lastPosition_.tick +
+           (time - lastPosition_.time) / lastPosition_.oneTickTime;
+  }
+
   Track& getTrackByChannel(int channel) {
-    if (channel <= STEP_SEQ_NUM_MONO_TRACKS) {
+    if (channel <= numMonoTracks) {
       return getMonoTrack(channel - 1);
     } else {
-      return getPolyTrack(channel - 1 - STEP_SEQ_NUM_MONO_TRACKS);
+      return getPolyTrack(channel - 1 - numMonoTracks);
     }
   }
 
@@ -94,25 +248,173 @@ public:
 
   PolyTrack& getPolyTrack(int index) { return polyTracks_[index]; }
 
+  // reset every step of every track (track settings are kept)
+  void clearSteps() {
+    for (auto& track : monoTracks_) {
+      track.clearSteps();
+    }
+    for (auto& track : polyTracks_) {
+      track.clearSteps();
+    }
+  }
+
   // deltaTime is in seconds, call this frequenctly, preferably over 1kHz
   void process(double deltaTime);
 
+  // slave mode: incoming MIDI clock drives the ticks instead of the tempo
+  // each pulse releases {ticksPerClock} ticks, spread over the pulse period
+  // as filtered by the clock follower, and the tempo follows the clock
+  void setSyncToMidiClock(bool sync) { syncToMidiClock_ = sync; }
+  bool isSyncedToMidiClock() const { return syncToMidiClock_; }
+
+  // call for every incoming MIDI clock message, {time} in seconds
+  // (the pulses after a MIDI start count from the start of the pattern)
+  void handleMidiClock(double time) {
+    clock_.pulse(time);
+    if (running_) {
+      pendingClocks_.fetch_add(1);
+    }
+  }
+
+  const ClockFollower& getClockFollower() const { return clock_; }
+
+  // host sync: the play position follows the host transport, posted once
+  // per audio block with setHostPosition(), instead of running on its own
+  // the host also starts and stops the sequencer, the tempo is still set
+  // with setBpm()
+  void setSyncToHost(bool sync) { syncToHost_ = sync; }
+  bool isSyncedToHost() const { return syncToHost_; }
+
+  // the host is at {ppqPosition} quarter notes at {time} (seconds, same
+  // clock as start()), and {playing} or not
+  // may be called from another thread than process()
+  void setHostPosition(double ppqPosition, double time, bool playing);
+
+  // how far (in seconds) the time stamps were off the latest host position
+  // (or shared clock position) before they were lined up with it again. a
+  // host jump shows up here, a steady tempo stays well below a sample
+  double getHostPhaseError() const { return hostPhaseError_.load(); }
+
+  // shared clock (see SharedClock.h): the leader publishes its timeline to
+  // {clock} whenever it moves, a follower's play position, tempo and
+  // transport follow {clock} instead of its own timer (like with
+  // setSyncToHost(), which it takes precedence over). nullptr for neither
+  // {clock} must outlive its use, may be called from another thread than
+  // process()
+  enum class SharedClockRole { Lead, Follow };
+  void setSharedClock(SharedClock* clock, SharedClockRole role) {
+    leadClock_.store(role == SharedClockRole::Lead ? clock : nullptr);
+    followClock_.store(role == SharedClockRole::Follow ? clock : nullptr);
+  }
+  bool isFollowingSharedClock() const {
+    return followClock_.load() != nullptr;
+  }
+
+  // master mode: sends MIDI clock (every {ticksPerClock} ticks) and start,
+  // stop, continue and song position pointer (on rewind()) through
+  // sendClockMessage, stamped on the same tick timeline as the notes
+  void setSendMidiClock(bool send) { sendMidiClock_ = send; }
+  bool isSendingMidiClock() const { return sendMidiClock_; }
+
+  // advance all tracks by exactly one tick regardless of wall-clock time
+  // process() calls this once enough time has passed, the offline renderer
+  // calls it in a tight loop
+  void tick();
+
+  // TODO: alternative time signatures
+  // at the play position
+  double getOneTickTime() const { return 15.0 / bpm_ / Config::ticksPerStep; }
+
+  // when {tick} (since start) plays, in seconds on the clock of start()
+  double getTickTime(double tick) const {
+    return startTime_ + tempo_.getTime(tick);
+  }
+
+  // like Track::sendMidiMessage, the message is stamped with its tick
+  std::function<void(juce::MidiMessage msg)> sendClockMessage;
+
+  // the track events sent ahead of time go to the collector once they are
+  // due, call from the audio thread right before taking a block from it
+  // (see OutputQueue.h)
+  void releaseDueEvents() {
+    outbox_.release(midiCollector_,
+                    juce::Time::getMillisecondCounterHiRes() * 0.001);
+  }
+
   std::function<void(int track_index, int step_index, MonoStep step)>
       notifyProcessorMonoStepUpdate;
 
   std::function<void(int track_index, int step_index, PolyStep step)>
       notifyProcessorPolyStepUpdate;
 
-  // tick-based timekeeping for MIDI clock sync
-  // void tick(juce::MidiMessageCollector& collector);
 private:
-  MonoTrack monoTracks_[STEP_SEQ_NUM_MONO_TRACKS];
-  PolyTrack polyTracks_[STEP_SEQ_NUM_POLY_TRACKS];
+  std::array<MonoTrack, numMonoTracks> monoTracks_;
+  std::array<PolyTrack, numPolyTracks> polyTracks_;
+
+  // tracks have no default constructor, so the arrays are built in place
+  // with channels 1..numMonoTracks and numMonoTracks+1..numTracks
+  template <typename T, int FirstChannel, std::size_t... I>
+  static std::array<T, sizeof...(I)> makeTracks(
+      const KeyboardMonitor& keyboard,
+      std::index_sequence<I...>) {
+    return {{T(FirstChannel + static_cast<int>(I), keyboard)...}};
+  }
+  // tempo at the play position, and the tempo over the whole timeline
   double bpm_;
-  // TODO: alternative time signatures
-  double getOneTickTime() const { return 15.0 / bpm_ / TICKS_PER_STEP; }
+  TempoMap tempo_;
+  // a tempo and its ramp are requested together, in one word, so a tempo
+  // is never applied with the ramp of another request (a SeqLock would need
+  // a single writer)
+  struct TempoRequest {
+    float bpm;
+    float rampSteps;
+  };
+  static_assert(std::atomic<TempoRequest>::is_always_lock_free);
+  std::atomic<TempoRequest> requestedTempo_;
+  double appliedBpm_;  // the request tempo_ has
+  // tempo changes are kept for a bar behind the play position, so the ticks
+  // just played still convert to the times they were played at
+  static constexpr int TEMPO_HISTORY_TICKS = Config::ticksPerStep * 16;
+  // at most one change per tick of that, plus the end of a ramp ahead (and
+  // a jump), so tempo_ never has to grow
+  static constexpr int TEMPO_SEGMENTS = TEMPO_HISTORY_TICKS + 4;
+  void applyTempo();
 
-  double getOneStepTime() const { return TICKS_PER_STEP * getOneTickTime(); }
+  // delays in ms to ticks at the current tempo (rounded to the nearest tick)
+  // the clock output has no delay of its own, it only follows the latency
+  // (on the tick thread only, the tracks keep their delay in plain ints)
+  void updateTrackDelays() {
+    for (int channel = 1; channel <= numTracks; ++channel) {
+      double seconds =
+          trackDelaysMs_[channel - 1].load() * 0.001 + getLatency();
+      getTrackByChannel(channel).setDelay(
+          static_cast<int>(std::lround(seconds / getOneTickTime())));
+    }
+    clockDelayTicks_ =
+        static_cast<int>(std::lround(getLatency() / getOneTickTime()));
+  }
+
+  void updateTrackSwings() {
+    for (int channel = 1; channel <= numTracks; ++channel) {
+      getTrackByChannel(channel).setSwing(swingTicks_ +
+                                          trackSwingTicks_[channel - 1]);
+    }
+  }
+
+  // ticks since start to seconds, then out to the collector
+  void sendToCollector(const juce::MidiMessage& msg);
+  // the same for track events, which may be ahead of time: they wait in
+  // {outbox_} (see releaseDueEvents())
+  void sendToOutbox(const juce::MidiMessage& msg);
+  static constexpr int OUTBOX_SIZE = 1024;
+  OutputQueue<OUTBOX_SIZE> outbox_;
+
+  // requested, see setTrackDelay()
+  std::array<std::atomic<double>, numTracks> trackDelaysMs_{};
+  std::atomic<bool> hostCompensatesLatency_{false};
+  std::atomic<bool> delaysChanged_{false};
+  int swingTicks_ = 0;
+  std::array<int, numTracks> trackSwingTicks_{};
 
   // function-related variables
   bool running_;
@@ -122,14 +424,103 @@ private:
   double timeSinceStart_;
   double startTime_;
 
-  // timestamp in (fractional) steps
+  // slave mode (see setSyncToMidiClock())
+  void followMidiClock(double deltaTime);
+  bool syncToMidiClock_ = false;
+  ClockFollower clock_;
+  std::atomic<int> pendingClocks_{0};  // received, not yet played
+  int clocksSinceStart_ = 0;
+  int ticksToPlay_ = 0;  // of the latest pulse
+  double timeSincePulse_ = 0.0;
+
+  // master mode (see setSendMidiClock())
+  void sendClock(juce::MidiMessage msg) {
+    if (sendMidiClock_ && sendClockMessage) {
+      sendClockMessage(msg.withTimeStamp(
+          static_cast<double>(clockTick_ + clockDelayTicks_)));
+    }
+  }
+  bool sendMidiClock_ = false;
+  juce::int64 clockTick_ = 0;  // the next tick to play, since start
+  int clockDelayTicks_ = 0;
+
+  void returnToStart();
+
+  // for getTickAtTime(), published whenever the timeline moves, from the
+  // tick thread only (a SeqLock has one writer). start(), stop() and
+  // resume() may be called from other threads, they leave it to the next
+  // process() with {positionMoved_}
+  struct PlayPosition {
+    double tick;
+    double time;
+    double oneTickTime;
+  };
+  SeqLock<PlayPosition> position_;
+  mutable PlayPosition lastPosition_;  // read by getTickAtTime()
+  std::atomic<bool> positionMoved_{false};
+  PlayPosition getPlayPosition() const {
+    auto tick = static_cast<double>(clockTick_);
+    return {tick, getTickTime(tick), getOneTickTime()};
+  }
+  void publishPosition() {
+    PlayPosition position = getPlayPosition();
+    position_.store(position);
+    if (auto* clock = leadClock_.load()) {
+      clock->publish({position.tick, position.time, bpm_, running_});
+    }
+  }
+
+  // shared clock (see setSharedClock())
+  std::atomic<SharedClock*> leadClock_{nullptr};
+  std::atomic<SharedClock*> followClock_{nullptr};
+  unsigned sharedVersionRead_ = 0;
+  void followSharedClock(const SharedClock& clock, double deltaTime);
+
+  // host sync (see setSyncToHost())
+  struct HostPosition {
+    double ppq;
+    double time;
+    bool playing;
+  };
+  void followHost(double deltaTime);
+  // lines the timeline up with {tick} playing at {time}, starts or stops
+  // with {playing}
+  void lineUp(double tick, double time, bool playing);
+  // plays the ticks the position lined up with has moved on to
+  void followPosition(double deltaTime);
+  bool syncToHost_ = false;
+  SeqLock<HostPosition> host_;
+  unsigned hostVersionRead_ = 0;
+  std::atomic<double> hostPhaseError_{0.0};
+  double hostTick_ = 0.0;  // of the latest host position
+  double timeSinceHost_ = 0.0;
+
+  // offset and length in ticks
   Note calculateNoteFromNoteOnAndOff(juce::MidiMessage noteOn,
                                      juce::MidiMessage noteOff);
 
+  // recording input on its way from the audio thread, kept small so a burst
+  // of chords fits (a dropped note off would leave the key held)
+  struct RecordedNote {
+    double tick;
+    juce::uint8 channel;
+    juce::uint8 number;
+    juce::uint8 velocity;
+    bool isNoteOn;
+  };
+  static constexpr int RECORD_QUEUE_SIZE = 1024;
+  Fifo<RecordedNote, RECORD_QUEUE_SIZE> recorded_;
+  void mergeRecordedNotes();
+  void recordNoteOn(juce::MidiMessage noteOn);
+  void recordNoteOff(juce::MidiMessage noteOff);
+
+  // only touched by the tick thread
   KeyboardMonitor keyboardMonitor_;
 
   // std::optional<juce::MidiMessage> keyState_[STEP_SEQ_MAX_LENGTH];
   juce::MidiMessageCollector& midiCollector_;
 };
 
+using E3Sequencer = BasicE3Sequencer<DefaultConfig>;
+
 }  // namespace Sequencer
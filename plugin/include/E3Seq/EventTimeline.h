@@ -0,0 +1,198 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>  // juce::MidiMessage
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+
+/*
+  future MIDI events of one track, on an absolute tick timeline
+
+  the timeline counts ticks since the track started and never wraps, so an
+  event can be any distance ahead (a note held over several loops, a note
+  off after the track got shorter) and stays where it was put
+
+  every event carries the tag of the step rendering that put it there, so a
+  step rendered ahead of time can take its events back (see removeTagged())
+
+  the events live in a fixed pool of {CAPACITY} and are linked into a timing
+  wheel: one list per tick modulo {WHEEL_SIZE}, sorted by tick. adding an
+  event only walks the list of its own tick, handing out the events of a tick
+  only looks at the head of that list, and nothing is ever allocated (so it is
+  safe on the tick thread). an event further ahead than the wheel waits in
+  its list behind the nearer ones until its tick comes round
+*/
+
+namespace Sequencer {
+
+class EventTimeline {
+public:
+  using Tag = juce::int64;
+
+  // pending events, add() refuses any more
+  static constexpr int CAPACITY = 1024;
+
+  EventTimeline() { clear(); }
+
+  // events for ticks already handed out are moved to {now}, so they are
+  // still sent (late) instead of being lost behind the read position
+  // the message is time stamped with its tick on the timeline
+  // returns false, and drops the event, if the timeline is full
+  bool add(juce::MidiMessage message,
+           juce::int64 tick,
+           Tag tag,
+           juce::int64 now) {
+    if (free_ == NONE)
+      return false;
+
+    tick = std::max(tick, now);
+    message.setTimeStamp(static_cast<double>(tick));
+    int index = free_;
+    Event& event = events_[slot(index)];
+    free_ = event.next;
+    event.tick = tick;
+    event.tag = tag;
+    event.message = std::move(message);
+
+    // after the events of the same tick, so they keep the order they came in
+    // (a tick already handed out, after a shorter delay, waits in {late_})
+    int* link = tick <= handedOut_ ? &late_ : &buckets_[bucket(tick)];
+    while (*link != NONE && events_[slot(*link)].tick <= tick) {
+      link = &events_[slot(*link)].next;
+    }
+    event.next = *link;
+    *link = index;
+    ++numPending_;
+    return true;
+  }
+
+  // calls {send} for every event at or before {tick}
+  template <typename Function>
+  void popDue(juce::int64 tick, Function&& send) {
+    popList(late_, tick, send);
+    // the lists of every tick since the last one handed out (all of them
+    // once, after a jump further than the wheel)
+    juce::int64 from = std::max(handedOut_ + 1, tick - WHEEL_SIZE + 1);
+    for (juce::int64 t = from; t <= tick; ++t) {
+      popList(buckets_[bucket(t)], tick, send);
+    }
+    handedOut_ = std::max(handedOut_, tick);
+  }
+
+  // removes the pending note offs of {noteNumber} at or after {tick}
+  // returns the tag of (one of) them, if there was any
+  std::optional<Tag> removeNoteOffs(int noteNumber, juce::int64 tick) {
+    std::optional<Tag> removed;
+    removeIf([&](const Event& event) {
+      if (event.tick < tick || !event.message.isNoteOff() ||
+          event.message.getNoteNumber() != noteNumber)
+        return false;
+      removed = event.tag;
+      return true;
+    });
+    return removed;
+  }
+
+  // removes the pending events tagged {tag}
+  void removeTagged(Tag tag) {
+    removeIf([tag](const Event& event) { return event.tag == tag; });
+  }
+
+  void clear() {
+    buckets_.fill(NONE);
+    late_ = NONE;
+    for (int i = 0; i < CAPACITY; ++i) {
+      events_[slot(i)].next = i + 1 < CAPACITY ? i + 1 : NONE;
+    }
+    free_ = 0;
+    numPending_ = 0;
+    handedOut_ = std::numeric_limits<juce::int64>::min();
+  }
+
+  // calls {send} for every pending note off, then clears the timeline
+  // (for a jump of the read position: nothing in between is played, but the
+  // notes that are on must still end)
+  template <typename Function>
+  void clearEndingNotes(Function&& send) {
+    forEachList([&](int& head) {
+      for (int i = head; i != NONE; i = events_[slot(i)].next) {
+        if (events_[slot(i)].message.isNoteOff()) {
+          send(events_[slot(i)].message);
+        }
+      }
+    });
+    clear();
+  }
+
+  int getNumPending() const { return numPending_; }
+  int getNumFree() const { return CAPACITY - numPending_; }
+
+private:
+  // a power of two, well past the lookahead plus a typical note length
+  static constexpr int WHEEL_SIZE = 256;
+  static constexpr int NONE = -1;
+
+  struct Event {
+    juce::int64 tick = 0;
+    Tag tag = 0;
+    juce::MidiMessage message;
+    int next = NONE;  // in its list, or in the free list
+  };
+
+  static size_t slot(int i) { return static_cast<size_t>(i); }
+  static size_t bucket(juce::int64 tick) {
+    return static_cast<size_t>(tick & (WHEEL_SIZE - 1));
+  }
+
+  void release(int index) {
+    events_[slot(index)].next = free_;
+    free_ = index;
+    --numPending_;
+  }
+
+  template <typename Function>
+  void popList(int& head, juce::int64 tick, Function& send) {
+    while (head != NONE && events_[slot(head)].tick <= tick) {
+      int index = head;
+      head = events_[slot(index)].next;
+      send(events_[slot(index)].message);
+      release(index);
+    }
+  }
+
+  // the late events first, then the wheel from the next tick to hand out
+  template <typename Function>
+  void forEachList(Function&& function) {
+    function(late_);
+    for (int i = 0; i < WHEEL_SIZE; ++i) {
+      function(buckets_[bucket(handedOut_ + 1 + i)]);
+    }
+  }
+
+  template <typename Predicate>
+  void removeIf(Predicate&& remove) {
+    if (numPending_ == 0)
+      return;
+    forEachList([&](int& head) {
+      int* link = &head;
+      while (*link != NONE) {
+        int index = *link;
+        if (remove(events_[slot(index)])) {
+          *link = events_[slot(index)].next;
+          release(index);
+        } else {
+          link = &events_[slot(index)].next;
+        }
+      }
+    });
+  }
+
+  std::array<Event, CAPACITY> events_;
+  std::array<int, WHEEL_SIZE> buckets_;
+  int late_ = NONE;
+  int free_ = NONE;
+  int numPending_ = 0;
+  juce::int64 handedOut_ = 0;  // the last tick handed out
+};
+
+}  // namespace Sequencer
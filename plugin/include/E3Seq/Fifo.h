@@ -0,0 +1,49 @@
+#pragma once
+#include <juce_core/juce_core.h>  // juce::AbstractFifo
+#include <array>
+
+/*
+  a fixed size queue from one thread to one other, without locks or
+  allocation (on top of juce::AbstractFifo, which only moves two indices)
+
+  push() and pop() never wait: a full queue drops what is pushed, an empty one
+  has nothing to pop. it holds {Capacity} - 1 values
+*/
+
+namespace Sequencer {
+
+template <typename T, int Capacity>
+class Fifo {
+public:
+  // from the writing thread, false if the queue is full
+  bool push(const T& value) {
+    int start1, size1, start2, size2;
+    fifo_.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0)
+      return false;
+
+    items_[static_cast<size_t>(size1 > 0 ? start1 : start2)] = value;
+    fifo_.finishedWrite(1);
+    return true;
+  }
+
+  // from the reading thread, false if the queue is empty
+  bool pop(T& value) {
+    int start1, size1, start2, size2;
+    fifo_.prepareToRead(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0)
+      return false;
+
+    value = items_[static_cast<size_t>(size1 > 0 ? start1 : start2)];
+    fifo_.finishedRead(1);
+    return true;
+  }
+
+  int getNumReady() const { return fifo_.getNumReady(); }
+
+private:
+  juce::AbstractFifo fifo_{Capacity};
+  std::array<T, Capacity> items_{};
+};
+
+}  // namespace Sequencer
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+
+/*
+  time of incoming MIDI, for recording and the MIDI transport messages
+
+  incoming MIDI comes with sample offsets into the audio block. a block is
+  taken to end when processBlock() is called, which is also where the output
+  side starts the next block (see juce::MidiMessageCollector), so input and
+  output share one time line:
+
+    time(offset) = {block end} - ({block length} - offset) / {sample rate}
+                   - {input latency}
+
+  the callback times jitter with the audio thread, so the block ends are
+  counted in samples instead, and only pulled slowly towards the callback
+  times (a first order loop, {gain} per block). a callback off by more than
+  MAX_ERROR (a dropout, a stalled thread, another sample rate) restarts the
+  count from there
+
+  beginBlock() and getTime() are called on the audio thread, setLatency()
+  from anywhere
+*/
+
+namespace Sequencer {
+
+class InputClock {
+public:
+  static constexpr double MAX_ERROR = 0.01;
+
+  explicit InputClock(double gain = 0.05) : gain_(gain) {}
+
+  // at the start of every audio block, {callbackTime} in seconds
+  void beginBlock(double callbackTime, int numSamples, double sampleRate) {
+    double length = numSamples / sampleRate;
+    double predicted = blockEnd_ + length;
+    double error = callbackTime - predicted;
+    if (sampleRate != sampleRate_ || std::abs(error) > MAX_ERROR) {
+      blockEnd_ = callbackTime;
+    } else {
+      blockEnd_ = predicted + gain_ * error;
+    }
+    sampleRate_ = sampleRate;
+    blockStart_ = blockEnd_ - length;
+  }
+
+  // when the MIDI at {sampleOffset} into the block was played, in seconds
+  double getTime(int sampleOffset) const {
+    return blockStart_ + sampleOffset / sampleRate_ - getLatency();
+  }
+
+  // of the MIDI interface and whatever is in front of it, in seconds
+  void setLatency(double seconds) { latency_.store(seconds); }
+  double getLatency() const { return latency_.load(); }
+
+private:
+  const double gain_;
+  double sampleRate_ = 0.0;
+  double blockEnd_ = 0.0;
+  double blockStart_ = 0.0;
+  std::atomic<double> latency_{0.0};
+};
+
+}  // namespace Sequencer
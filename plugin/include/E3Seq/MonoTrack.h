@@ -6,45 +6,61 @@
 
 #include "E3Seq/Step.h"
 #include "E3Seq/Track.h"
+#include "E3Seq/PagedSteps.h"
 
 namespace Sequencer {
-class MonoTrack : public Track {
+template <typename Config>
+class BasicMonoTrack : public BasicTrack<Config> {
 public:
-  MonoTrack(int channel,
-            const KeyboardMonitor& keyboard,
-            int length = STEP_SEQ_DEFAULT_LENGTH,
-            PlayMode mode = PlayMode::Forward)
-      : Track(channel, keyboard, length, mode) {}
+  using Base = BasicTrack<Config>;
+  using typename Base::PlayMode;
+  using Base::ticksPerStep;
+  using Step = BasicMonoStep<Config>;
+
+  BasicMonoTrack(int channel,
+                 const KeyboardMonitor& keyboard,
+                 int length = Config::defaultLength,
+                 PlayMode mode = PlayMode::Forward)
+      : Base(channel, keyboard, length, mode) {
+    steps_.reserve(length);
+  }
 
   // sequencer programmer interface
   void setStepAtIndex(int index,
-                      MonoStep step,
+                      Step step,
                       bool ignore_alternate_count = false) {
     if (ignore_alternate_count) {
-      step.count = steps_[index].count;
+      const auto* page = steps_.findPage(index);
+      step.count = page != nullptr ? page->count[steps_.slotOf(index)] : 0;
     }
 
-    steps_[index] = step;
+    // (the processor writes every step of the page on each sync, only
+    // actual changes count as edits)
+    if (steps_.set(index, step)) {
+      this->markEdited(index);
+    }
+    this->scheduleStep(index, step.enabled, step.note.offset_ticks);
   }
 
-  MonoStep getStepAtIndex(int index) const { return steps_[index]; }
+  Step getStepAtIndex(int index) const { return steps_[index]; }
 
-private:
-  MonoStep steps_[STEP_SEQ_MAX_LENGTH];
-
-  int getStepNoteOnTick(int index) const {
-    return static_cast<int>((index + steps_[index].note.offset) *
-                            TICKS_PER_STEP);
+  // disable every step (the memory is kept)
+  void clearSteps() {
+    steps_.clear();
+    this->unscheduleAllSteps();
   }
 
-  int getStepNoteOffTick(int index) const {
-    return static_cast<int>(
-        (index + steps_[index].note.offset + steps_[index].note.length) *
-        TICKS_PER_STEP);
-  }
+  std::size_t getStepMemoryUsage() const { return steps_.getMemoryUsage(); }
+
+private:
+  PagedSteps<Step, Config::pageLength, Config::maxLength> steps_;
+
+  void reserveSteps(int length) override final { steps_.reserve(length); }
 
-  int getStepRenderTick(int index) const override final {
-    return getStepNoteOnTick(index);
+  // a mono step is rendered at its note on, so for enabled steps the render
+  // schedule is also the note on schedule
+  int getStepNoteOnTick(int index) const {
+    return this->getStepRenderTick(index);
   }
 
   // TODO: refactor this to use renderNote instead of renderMidiMessage
@@ -52,71 +68,82 @@ private:
   // midi messages and incorporate that into the step parameter
   // after that, make renderMidiMessage private instead of protected
   void renderStep(int index) override final {
-    auto& step = steps_[index];
-    if (step.enabled) {
+    auto* page = steps_.findPage(index);
+    if (page == nullptr) {
+      return;  // nothing was ever written on this page
+    }
+
+    int slot = steps_.slotOf(index);
+    if (page->enabled[slot]) {
       // alternate check
-      if ((step.count++) % step.alternate != 0) {
+      if (!page->advanceAlternate(slot)) {
         return;
       }
 
       // probability check
-      if (juce::Random::getSystemRandom().nextFloat() >= step.probability) {
+      if (this->rng_.nextFloat() >= page->getProbability(slot)) {
         return;
       }
 
+      // (the note on and its note off)
+      if (!this->hasRoomFor(2)) {
+        return;
+      }
+
+      const Step step = page->get(slot);
       int note_on_tick = getStepNoteOnTick(index);
-      int note_off_tick = getStepNoteOffTick(index);
+      int note_off_tick = note_on_tick + step.note.length_ticks;
 
       // force note off before the next active step
       // TODO: this still doesn't feel like the right thing to do
       // maybe it makes more sense to reconsider this code from the perspective
       // of polytrack note stealing behaviour
       // i.e make the code for mono & poly tracks more unified
-      int next_active_step_index = (index + 1) % getLength();
-      while (!getStepAtIndex(next_active_step_index).enabled) {
-        next_active_step_index = (next_active_step_index + 1) % getLength();
-      }
-
-      if (next_active_step_index > index) {
-        note_off_tick =
-            std::min(note_off_tick, getStepNoteOnTick(next_active_step_index));
-      } else if (next_active_step_index < index) {
-        note_off_tick = std::min(
-            note_off_tick, getStepNoteOnTick(next_active_step_index) +
-                               TICKS_PER_STEP * getLength());  // is this ok?
+      // (in play order, see setPlayMode())
+      int next_note_on_tick = this->getNextNoteOnTick();
+      if (next_note_on_tick != Base::NOT_RENDERED) {
+        note_off_tick = std::min(note_off_tick, next_note_on_tick);
       }
 
       // note on
-      juce::MidiMessage note_on_message = juce::MidiMessage::noteOn(
-          getChannel(), step.note.number, (juce::uint8)step.note.velocity);
+      juce::MidiMessage note_on_message =
+          juce::MidiMessage::noteOn(this->getChannel(), step.note.number,
+                                    (juce::uint8)step.note.velocity);
       note_on_message.setTimeStamp(note_on_tick);
-      renderMidiMessage(note_on_message);
+      this->renderMidiMessage(note_on_message);
 
       // retrigger
-      if (step.retrigger_rate > 0.0) {
-        int retrigger_interval_in_ticks =
-            static_cast<int>(step.retrigger_rate * TICKS_PER_STEP);
-        for (int tick = note_on_tick + retrigger_interval_in_ticks;
-             tick < note_off_tick; tick += retrigger_interval_in_ticks) {
+      // on the straight grid of the step, from the first one after the
+      // (swung) note on
+      if (step.retrigger_ticks > 0) {
+        int swing = this->getRenderSwing();
+        int first = (swing / step.retrigger_ticks + 1) * step.retrigger_ticks;
+        // (as many as fit before the note off)
+        for (int tick = note_on_tick + first - swing;
+             tick < note_off_tick && this->hasRoomFor(3);
+             tick += step.retrigger_ticks) {
           juce::MidiMessage retrigger_note_off_message =
-              juce::MidiMessage::noteOff(getChannel(), step.note.number,
+              juce::MidiMessage::noteOff(this->getChannel(), step.note.number,
                                          (juce::uint8)step.note.velocity);
           retrigger_note_off_message.setTimeStamp(tick);
           juce::MidiMessage retrigger_note_on_message =
-              juce::MidiMessage::noteOn(getChannel(), step.note.number,
+              juce::MidiMessage::noteOn(this->getChannel(), step.note.number,
                                         (juce::uint8)step.note.velocity);
           retrigger_note_on_message.setTimeStamp(tick);
-          renderMidiMessage(retrigger_note_off_message);
-          renderMidiMessage(retrigger_note_on_message);
+          this->renderMidiMessage(retrigger_note_off_message);
+          this->renderMidiMessage(retrigger_note_on_message);
         }
       }
 
       // note off
-      juce::MidiMessage note_off_message = juce::MidiMessage::noteOff(
-          getChannel(), step.note.number, (juce::uint8)step.note.velocity);
+      juce::MidiMessage note_off_message =
+          juce::MidiMessage::noteOff(this->getChannel(), step.note.number,
+                                     (juce::uint8)step.note.velocity);
       note_off_message.setTimeStamp(note_off_tick);
-      renderMidiMessage(note_off_message);
+      this->renderMidiMessage(note_off_message);
     }
   }
 };
+
+using MonoTrack = BasicMonoTrack<DefaultConfig>;
 }  // namespace Sequencer
@@ -0,0 +1,58 @@
+#pragma once
+#include "E3Seq/E3Sequencer.h"
+
+/*
+  offline (faster than real-time) rendering of the sequencer output
+
+  the renderer drives E3Sequencer::tick() in a tight loop instead of waiting
+  for the hi-res timer, collects whatever the tracks send and writes it out as
+  a Standard MIDI File. timestamps are kept in ticks all the way through, so
+  one tick maps to exactly one MIDI file tick ({TICKS_PER_STEP} * 4 ppq)
+*/
+
+namespace Sequencer {
+
+class OfflineRenderer {
+public:
+  explicit OfflineRenderer(double bpm = BPM_DEFAULT);
+
+  OfflineRenderer(const OfflineRenderer&) = delete;
+  OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+  ~OfflineRenderer() = default;
+
+  // expects the XML written by AudioPluginAudioProcessor::savePreset()
+  // parameters missing from the preset keep their default values
+  // returns false if the XML does not look like an E3Seq state
+  bool loadPreset(const juce::XmlElement& xml);
+
+  // seeds the probability generator of every track
+  void setSeed(juce::int64 seed);
+
+  // render {numLoops} times the length of the longest track
+  juce::MidiMessageSequence renderLoops(int numLoops);
+
+  // render {seconds} of sequencer output at the current BPM
+  juce::MidiMessageSequence renderDuration(double seconds);
+
+  // one MIDI file track per sequencer track, plus a tempo track
+  bool writeMidiFile(const juce::MidiMessageSequence& sequence,
+                     const juce::File& file) const;
+
+  E3Sequencer& getSequencer() { return sequencer_; }
+
+  static constexpr int MIDI_FILE_PPQ = TICKS_PER_STEP * 4;
+
+private:
+  juce::MidiMessageSequence renderTicks(int numTicks);
+
+  int getLoopLengthInTicks();
+
+  // the sequencer insists on a collector even though nothing is sent there
+  juce::MidiMessageCollector collector_;
+  E3Sequencer sequencer_;
+
+  juce::MidiMessageSequence rendered_;
+  int currentTick_;
+};
+
+}  // namespace Sequencer
@@ -0,0 +1,78 @@
+#pragma once
+#include "E3Seq/Fifo.h"
+#include <juce_audio_devices/juce_audio_devices.h>  // juce::MidiMessageCollector
+#include <array>
+#include <atomic>
+
+/*
+  MIDI events sent ahead of time, held until they are due
+
+  tracks send their events a little before they play (see
+  Track::setLookahead()), stamped with the time they play at. a
+  juce::MidiMessageCollector puts whatever it gets into the next block (and
+  throws old ones away once one is a second ahead), so the events wait here
+  instead: release() hands the ones that are due to the collector, from the
+  audio thread right before it takes its block. a tick thread that is late
+  then no longer makes the note late, as long as it is not later than the
+  events were sent ahead
+
+  one thread pushes, the audio thread releases, and nothing is allocated
+*/
+
+namespace Sequencer {
+
+template <int Capacity>
+class OutputQueue {
+public:
+  // from the sending thread, {message} stamped in seconds (on
+  // juce::Time::getMillisecondCounterHiRes()), false if the queue is full
+  bool push(const juce::MidiMessage& message) {
+    return fifo_.push(Item{message, generation_.load()});
+  }
+
+  // from any thread: what was pushed so far is not released any more (the
+  // sequencer stopped or jumped), except the note offs, which go out at the
+  // next release() in case their note was already on
+  void drop() { generation_.fetch_add(1); }
+
+  // from the audio thread: the events due at {now} (in seconds) go to
+  // {collector}, the others are kept for a later block
+  void release(juce::MidiMessageCollector& collector, double now) {
+    unsigned generation = generation_.load();
+    Item item;
+    while (numHeld_ < Capacity && fifo_.pop(item)) {
+      held_[static_cast<size_t>(numHeld_++)] = item;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < numHeld_; ++i) {
+      const Item& held = held_[static_cast<size_t>(i)];
+      if (held.generation != generation) {
+        if (held.message.isNoteOff()) {
+          collector.addMessageToQueue(held.message.withTimeStamp(now));
+        }
+        continue;
+      }
+      if (held.message.getTimeStamp() <= now) {
+        collector.addMessageToQueue(held.message);
+      } else {
+        held_[static_cast<size_t>(kept++)] = held;
+      }
+    }
+    numHeld_ = kept;
+  }
+
+private:
+  struct Item {
+    juce::MidiMessage message;
+    unsigned generation = 0;
+  };
+
+  Fifo<Item, Capacity> fifo_;
+  std::atomic<unsigned> generation_{0};
+  // audio thread only
+  std::array<Item, Capacity> held_;
+  int numHeld_ = 0;
+};
+
+}  // namespace Sequencer
@@ -0,0 +1,130 @@
+#pragma once
+#include "E3Seq/StepColumns.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/*
+  step storage of a track, split into pages of {PageLength} steps
+
+  a page is only allocated the first time a non-default step is written into
+  it (or when the track grows over it, see reserve()), so a 256 step capable
+  track that only uses 16 steps costs one page. reads from a page that was
+  never allocated return a default (disabled) step
+
+  pages are never freed before the storage itself, which keeps reads from the
+  tick thread safe while the message thread allocates: the page pointers are
+  published with release/acquire and a page, once visible, stays valid
+
+  each page is stored column-wise (see StepColumns.h). steps go in and out
+  as whole Step values, code that only needs a field or two of a step reads
+  the columns of its page directly (findPage() and slotOf())
+*/
+
+namespace Sequencer {
+
+template <typename Step, int PageLength, int MaxLength>
+class PagedSteps {
+public:
+  static constexpr int pageLength = PageLength;
+  static constexpr int numPages = (MaxLength + PageLength - 1) / PageLength;
+  using Page = StepColumns<Step, PageLength>;
+
+  PagedSteps() {
+    for (auto& page : pages_) {
+      page.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  PagedSteps(const PagedSteps&) = delete;
+  PagedSteps& operator=(const PagedSteps&) = delete;
+
+  ~PagedSteps() {
+    for (auto& page : pages_) {
+      delete page.load(std::memory_order_relaxed);
+    }
+  }
+
+  Step operator[](int index) const {
+    const Page* page = findPage(index);
+    return page != nullptr ? page->get(slotOf(index)) : defaultStep;
+  }
+
+  // the page holding step {index}, nullptr if it was never allocated
+  Page* findPage(int index) {
+    return pages_[index / PageLength].load(std::memory_order_acquire);
+  }
+
+  const Page* findPage(int index) const {
+    return pages_[index / PageLength].load(std::memory_order_acquire);
+  }
+
+  // position of step {index} in the columns of its page
+  static constexpr int slotOf(int index) { return index % PageLength; }
+
+  // returns whether the stored step changed (compared as stored, so a value
+  // the compact format rounds the same way is no change)
+  bool set(int index, const Step& step) {
+    Page* page = pages_[index / PageLength].load(std::memory_order_acquire);
+    if (page == nullptr) {
+      if (step == defaultStep) {
+        return false;  // nothing to remember
+      }
+      page = allocate(index / PageLength);
+    }
+    const Step before = page->get(slotOf(index));
+    page->set(slotOf(index), step);
+    return !(page->get(slotOf(index)) == before);
+  }
+
+  // allocate every page up to {length} steps ahead of time, so that writes
+  // inside the track (e.g. live recording from the audio thread) never
+  // allocate
+  void reserve(int length) {
+    for (int i = 0; i * PageLength < length && i < numPages; ++i) {
+      if (pages_[i].load(std::memory_order_acquire) == nullptr) {
+        allocate(i);
+      }
+    }
+  }
+
+  // reset every allocated step to default, keeps the memory
+  void clear() {
+    for (auto& page : pages_) {
+      if (Page* p = page.load(std::memory_order_acquire)) {
+        p->fill(defaultStep);
+      }
+    }
+  }
+
+  bool isPageAllocated(int page) const {
+    return pages_[page].load(std::memory_order_acquire) != nullptr;
+  }
+
+  int getNumAllocatedPages() const {
+    int count = 0;
+    for (int i = 0; i < numPages; ++i) {
+      count += isPageAllocated(i) ? 1 : 0;
+    }
+    return count;
+  }
+
+  std::size_t getMemoryUsage() const {
+    return sizeof(*this) + getNumAllocatedPages() * sizeof(Page);
+  }
+
+  static inline const Step defaultStep{};
+
+private:
+
+  Page* allocate(int page) {
+    auto* new_page = new Page;
+    new_page->fill(defaultStep);
+    pages_[page].store(new_page, std::memory_order_release);
+    return new_page;
+  }
+
+  std::array<std::atomic<Page*>, numPages> pages_;
+};
+
+}  // namespace Sequencer
@@ -0,0 +1,40 @@
+#pragma once
+#include "E3Seq/E3Sequencer.h"
+
+/*
+  sparse XML form of the whole pattern
+
+  the host parameters only cover the page each track is editing, so presets
+  and the plugin state carry the complete pattern in a <PATTERN> element next
+  to the parameters. only steps that differ from the default are written, so
+  the size follows the number of steps in use rather than the maximum length:
+
+    <PATTERN>
+      <TRACK index="0">
+        <STEP index="17" enabled="1" note="62" offset="-0.25" .../>
+      </TRACK>
+      <TRACK index="8">
+        <STEP index="3" enabled="1" probability="0.5">
+          <NOTE index="0" number="60" velocity="100" offset="0" length="1"/>
+        </STEP>
+      </TRACK>
+    </PATTERN>
+
+  micro-timing is written in steps (like the parameters), so the format does
+  not depend on the tick resolution of the engine
+*/
+
+namespace Sequencer {
+
+class PatternState {
+public:
+  static constexpr const char* TAG = "PATTERN";
+
+  static std::unique_ptr<juce::XmlElement> write(E3Sequencer& sequencer);
+
+  // clears every track and loads the steps found in {pattern}
+  // returns false if {pattern} is not a <PATTERN> element
+  static bool read(const juce::XmlElement& pattern, E3Sequencer& sequencer);
+};
+
+}  // namespace Sequencer
@@ -56,6 +56,8 @@ private:
 
   juce::Label bpmLabel;
   juce::Slider bpmSlider;
+  juce::TextButton clockButton;
+  juce::TextButton clockOutButton;
 
   juce::TextButton quantizeButton;
 
@@ -4,6 +4,7 @@
 #include <juce_audio_devices/juce_audio_devices.h>
 
 #include "E3Seq/E3Sequencer.h"
+#include "E3Seq/InputClock.h"
 
 namespace audio_plugin {
 class AudioPluginAudioProcessor : public juce::AudioProcessor, 
@@ -62,37 +63,89 @@ public:
 private:
   juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+  // the T{t}_S{s}_* parameters are the STEP_SEQ_PAGE_LENGTH steps of the page
+  // selected by T{t}_PAGE, the rest of the pattern only lives in the sequencer
+  // and in the <PATTERN> element of the state (see PatternState.h)
+  std::unique_ptr<juce::XmlElement> createStateXml();
+  void restoreState(const juce::XmlElement& xml);
+
+  // copy the steps of the edited page from the sequencer into the parameters
+  void loadPageIntoParameters(int track);
+  void setMonoStepParameters(int track,
+                             int slot,
+                             const Sequencer::MonoStep& step);
+  void setPolyStepParameters(int track,
+                             int slot,
+                             const Sequencer::PolyStep& step);
+
+  // page whose steps the parameters currently hold, -1 forces a reload
+  std::atomic<int> editPages[STEP_SEQ_NUM_TRACKS];
+
+  // steps the sequencer changed (live recording, note stealing), queued by
+  // the sequencer thread and mirrored into the parameters by timerCallback()
+  template <typename Step>
+  struct StepUpdate {
+    int track;
+    int step;
+    Step value;
+  };
+  Sequencer::Fifo<StepUpdate<Sequencer::MonoStep>, 256> monoStepUpdates;
+  Sequencer::Fifo<StepUpdate<Sequencer::PolyStep>, 256> polyStepUpdates;
+  void applyStepUpdates();
+
+  // the shared clock (SHARED_CLOCK) of every instance on this machine, mapped
+  // from a file on first use and kept until the processor is gone (the
+  // sequencer thread may still be reading it when the role changes)
+  std::unique_ptr<juce::MemoryMappedFile> sharedClockFile;
+  int sharedClockRole = 0;  // index of the SHARED_CLOCK choice applied
+  Sequencer::SharedClock* openSharedClock();
+
   std::atomic<float>* mono_enabled_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                           [STEP_SEQ_MAX_LENGTH];
+                                           [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* mono_probability_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                               [STEP_SEQ_MAX_LENGTH];
+                                               [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* mono_note_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                        [STEP_SEQ_MAX_LENGTH];
+                                        [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* mono_velocity_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                            [STEP_SEQ_MAX_LENGTH];
+                                            [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* mono_offset_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                          [STEP_SEQ_MAX_LENGTH];
+                                          [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* mono_length_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                          [STEP_SEQ_MAX_LENGTH];
+                                          [STEP_SEQ_PAGE_LENGTH];
 
   std::atomic<float>* mono_retrigger_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                             [STEP_SEQ_MAX_LENGTH];
+                                             [STEP_SEQ_PAGE_LENGTH];
 
   std::atomic<float>* mono_alternate_pointers[STEP_SEQ_NUM_MONO_TRACKS]
-                                             [STEP_SEQ_MAX_LENGTH];
+                                             [STEP_SEQ_PAGE_LENGTH];
 
   std::atomic<float>* poly_enabled_pointers[STEP_SEQ_NUM_POLY_TRACKS]
-                                           [STEP_SEQ_MAX_LENGTH];
+                                           [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* poly_probability_pointers[STEP_SEQ_NUM_POLY_TRACKS]
-                                               [STEP_SEQ_MAX_LENGTH];
+                                               [STEP_SEQ_PAGE_LENGTH];
   std::atomic<float>* poly_note_pointers[STEP_SEQ_NUM_POLY_TRACKS]
-                                        [STEP_SEQ_MAX_LENGTH][POLYPHONY];
+                                        [STEP_SEQ_PAGE_LENGTH][POLYPHONY];
   std::atomic<float>* poly_velocity_pointers[STEP_SEQ_NUM_POLY_TRACKS]
-                                            [STEP_SEQ_MAX_LENGTH][POLYPHONY];
+                                            [STEP_SEQ_PAGE_LENGTH][POLYPHONY];
   std::atomic<float>* poly_offset_pointers[STEP_SEQ_NUM_POLY_TRACKS]
-                                          [STEP_SEQ_MAX_LENGTH][POLYPHONY];
+                                          [STEP_SEQ_PAGE_LENGTH][POLYPHONY];
   std::atomic<float>* poly_length_pointers[STEP_SEQ_NUM_POLY_TRACKS]
-                                          [STEP_SEQ_MAX_LENGTH][POLYPHONY];
+                                          [STEP_SEQ_PAGE_LENGTH][POLYPHONY];
+
+  std::atomic<float>* seed_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* seed_lock_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* track_length_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* page_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* delay_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* speed_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* resync_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* play_mode_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* track_swing_pointers[STEP_SEQ_NUM_TRACKS];
+  std::atomic<float>* input_latency_pointer;
+  std::atomic<float>* master_length_pointer;
+  std::atomic<float>* lookahead_pointer;
+  std::atomic<float>* swing_pointer;
+  std::atomic<float>* shared_clock_pointer;
 
   juce::MidiMessageCollector guiMidiCollector;
   juce::MidiMessageCollector seqMidiCollector;
@@ -100,6 +153,7 @@ private:
   std::unique_ptr<juce::MidiOutput> virtualMidiOut;
 
   double lastCallbackTime;
+  Sequencer::InputClock inputClock;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessor)
 };
@@ -1,73 +1,189 @@
 #include "E3Seq/Step.h"
 #include "E3Seq/Track.h"
 #include "E3Seq/KeyboardMonitor.h"
+#include "E3Seq/PagedSteps.h"
+#include <bitset>
+#include <utility>
 
 // this class serve as a data management layer between the core sequencer logic
 // (Track.cpp) and global sequencer state (E3Sequencer)
 
 namespace Sequencer {
-class PolyTrack : public Track {
+template <typename Config>
+class BasicPolyTrack : public BasicTrack<Config> {
 public:
-  PolyTrack(int channel,
-            const KeyboardMonitor& keyboard,
-            int length = STEP_SEQ_DEFAULT_LENGTH)
-      : Track(channel, keyboard, length) {}
+  using Base = BasicTrack<Config>;
+  using Base::ticksPerStep;
+  using Step = BasicPolyStep<Config>;
+  using Note = typename Step::Note;
+  static constexpr int polyphony = Config::polyphony;
+
+  BasicPolyTrack(int channel,
+                 const KeyboardMonitor& keyboard,
+                 int length = Config::defaultLength)
+      : Base(channel, keyboard, length) {
+    steps_.reserve(length);
+  }
 
   // note: there is some code duplication but I can't think of a better way
-  PolyStep getStepAtIndex(int index) const { return steps_[index]; }
+  Step getStepAtIndex(int index) const { return steps_[index]; }
+
+  void setStepAtIndex(int index, Step step) {
+    // (the processor writes every step of the page on each sync, only
+    // actual changes count as edits)
+    if (steps_.set(index, step)) {
+      this->markEdited(index);
+    }
+    this->scheduleStep(index, step.enabled, getEarliestOffset(step));
+  }
 
-  void setStepAtIndex(int index, PolyStep step) { steps_[index] = step; }
+  // reset every step (the memory is kept)
+  void clearSteps() {
+    steps_.clear();
+    this->unscheduleAllSteps();
+  }
+
+  std::size_t getStepMemoryUsage() const { return steps_.getMemoryUsage(); }
 
   void setEnableSmartOverdub(bool should) { smartOverdub = should; }
 
+  // the step changed by note stealing since the last call, or -1
+  int takeStolenStep() { return std::exchange(stolenIndex_, -1); }
+
 private:
-  PolyStep steps_[STEP_SEQ_MAX_LENGTH];
+  using VoiceMask = typename Step::VoiceMask;
+
+  PagedSteps<Step, Config::pageLength, Config::maxLength> steps_;
 
   bool smartOverdub = false;
 
-  int getStepRenderTick(int index) const override final {
-    float offset_min = 0.0f;
-    for (int i = 0; i < POLYPHONY; ++i) {
-      offset_min = std::min(offset_min, steps_[index].notes[i].offset);
+  // the step being played: its notes are rendered one by one, each at its
+  // own note on (see renderDueNotes())
+  int playingIndex_ = 0;
+  Note playingNotes_[polyphony];
+  VoiceMask pendingVoices_ = 0;    // voices of playingNotes_ not rendered yet
+  std::bitset<128> stealingKeys_;  // keys that already stole in this step
+  int stolenIndex_ = -1;
+
+  // a step is rendered from its earliest sounding note
+  static int getEarliestOffset(const Step& step) {
+    int offset_min = 0;
+    bool any = false;
+    for (int i = 0; i < polyphony; ++i) {
+      if (step.notes[i].number > DISABLED_NOTE) {
+        offset_min = any ? std::min(offset_min, step.notes[i].offset_ticks)
+                         : step.notes[i].offset_ticks;
+        any = true;
+      }
     }
-    return static_cast<int>((index + offset_min) * TICKS_PER_STEP);
+    return offset_min;
   }
 
-  // TODO: rework this such that each note is rendered at their respective note
-  // on timing
+  void reserveSteps(int length) override final { steps_.reserve(length); }
+
+  // the first note of an enabled step: decide on the step as a whole
+  // (probability), then play its notes as they come
   void renderStep(int index) override final {
-    auto& step = steps_[index];
-    if (step.enabled) {
-      // note stealing here
-      // its behaviour should not be affected by probability
-
-      // However, the correct approach is probably note-wise stealing
-      // i.e. each note should decide on its own
-      if (smartOverdub) {
-        if (keyboardRef.getActiveChannel() == this->getChannel()) {
-          auto active_notes = keyboardRef.getActiveNotes(POLYPHONY);
-          for (int note : active_notes) {
-            step.stealNote(note);
-          }
-        }
+    auto* page = steps_.findPage(index);
+    if (page == nullptr) {
+      return;  // nothing was ever written on this page
+    }
+
+    int slot = steps_.slotOf(index);
+    if (!page->enabled[slot]) {
+      return;
+    }
+
+    playingIndex_ = index;
+    pendingVoices_ = 0;
+    stealingKeys_.reset();
+
+    Step step = page->get(slot);
+    if (stealForHeldKeys(step)) {
+      storeStolen(step);
+    }
+
+    // in case note stealing disables the step
+    if (!step.enabled) {
+      return;
+    }
+
+    // probability check
+    if (this->rng_.nextFloat() >= step.probability) {
+      return;
+    }
+
+    for (int j = 0; j < polyphony; ++j) {
+      playingNotes_[j] = step.notes[j];
+      if (step.notes[j].number > DISABLED_NOTE) {
+        pendingVoices_ |= VoiceMask{1} << j;
       }
+    }
+    renderDueNotes(this->getStepRenderTick(index));
+  }
+
+  void renderPending(int tick) override final { renderDueNotes(tick); }
+
+  // renders the notes of the playing step whose note on is {tick} and
+  // schedules the next one, so the work per step is bounded by its notes and
+  // ticks without a due note cost nothing
+  void renderDueNotes(int tick) {
+    // smart overdub is decided note-wise: keys pressed since the previous
+    // note of this step steal now, and a note that got stolen is skipped
+    auto* page = steps_.findPage(playingIndex_);
+    Step step = page->get(steps_.slotOf(playingIndex_));
+    if (stealForHeldKeys(step)) {
+      storeStolen(step);
+    }
+    auto lanes = step.getNumberLanes();
 
-      // in case note stealing disables the step
-      if (!step.enabled) {
-        return;
+    int step_tick = playingIndex_ * ticksPerStep;
+    int next_tick = Base::NOT_RENDERED;
+    for (int j = 0; j < polyphony; ++j) {
+      if (!(pendingVoices_ & (VoiceMask{1} << j))) {
+        continue;
       }
 
-      // probability check
-      if (juce::Random::getSystemRandom().nextFloat() >= step.probability) {
-        return;
+      const Note& note = playingNotes_[j];
+      int note_tick = step_tick + note.offset_ticks;
+      if (note_tick == tick) {
+        pendingVoices_ &= ~(VoiceMask{1} << j);
+        if (step.enabled && Step::findEqual(lanes, note.number) != 0) {
+          this->renderNote(playingIndex_, note);
+        }
+      } else if (next_tick == Base::NOT_RENDERED || note_tick < next_tick) {
+        next_tick = note_tick;
       }
+    }
+    this->schedulePending(next_tick);
+  }
 
-      // render all notes in the step
-      for (int j = 0; j < POLYPHONY; ++j) {
-        // render note
-        renderNote(index, steps_[index].notes[j]);
+  // each held key steals (see PolyStep::stealNote()) once per step, at the
+  // first note of the step after it went down
+  bool stealForHeldKeys(Step& step) {
+    if (!smartOverdub ||
+        this->keyboardRef.getActiveChannel() != this->getChannel()) {
+      return false;
+    }
+
+    bool stolen = false;
+    for (int key : this->keyboardRef.getActiveNotes(polyphony)) {
+      if (!stealingKeys_.test(static_cast<size_t>(key))) {
+        stealingKeys_.set(static_cast<size_t>(key));
+        step.stealNote(key);
+        stolen = true;
       }
     }
+    return stolen;
+  }
+
+  // stealing edits the stored step, keep the schedule in line
+  void storeStolen(const Step& step) {
+    steps_.findPage(playingIndex_)->set(steps_.slotOf(playingIndex_), step);
+    this->scheduleStep(playingIndex_, step.enabled, getEarliestOffset(step));
+    stolenIndex_ = playingIndex_;
   }
 };
+
+using PolyTrack = BasicPolyTrack<DefaultConfig>;
 }  // namespace Sequencer
\ No newline at end of file
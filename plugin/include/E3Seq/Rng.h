@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+/*
+  xoshiro128+ pseudo random number generator (Blackman & Vigna)
+
+  every track owns one of these, so nothing random is shared between tracks,
+  plugin instances or threads, and a track seeded with the same value always
+  draws the same sequence. it is also a lot cheaper than juce::Random, which
+  matters since it is called from the tick path
+*/
+
+namespace Sequencer {
+
+class Rng {
+public:
+  explicit Rng(uint64_t seed = 0) { setSeed(seed); }
+
+  // the state is expanded from the seed with splitmix64 as recommended by
+  // the xoshiro authors, so similar seeds still give unrelated sequences
+  void setSeed(uint64_t seed) {
+    for (int i = 0; i < 4; i += 2) {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      z = z ^ (z >> 31);
+      s_[i] = static_cast<uint32_t>(z);
+      s_[i + 1] = static_cast<uint32_t>(z >> 32);
+    }
+  }
+
+  uint32_t next() {
+    const uint32_t result = s_[0] + s_[3];
+    const uint32_t t = s_[1] << 9;
+
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 11);
+
+    return result;
+  }
+
+  // uniform in [0, 1), only the upper 24 bits are used since the lowest bits
+  // of xoshiro128+ are weak
+  float nextFloat() { return static_cast<float>(next() >> 8) * 0x1.0p-24f; }
+
+private:
+  static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+  uint32_t s_[4];
+};
+
+}  // namespace Sequencer
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+  a small value written by one thread and read by others without locking
+
+  the writer makes a sequence count odd while it writes and even again
+  after, a reader that saw the count change (or odd) while it read drops what
+  it read. the value is kept in atomic words, so a torn read is detected
+  instead of being undefined
+
+  {T} must be trivially copyable (a few doubles and flags)
+*/
+
+namespace Sequencer {
+
+template <typename T>
+class SeqLock {
+public:
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  SeqLock() = default;
+  explicit SeqLock(const T& value) { store(value); }
+
+  // from one thread only: two stores at once can leave the count odd for
+  // good (every load() fails from then on), or mix their values
+  void store(const T& value) {
+    unsigned sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::array<std::uint64_t, WORDS> words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    for (size_t i = 0; i < WORDS; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  // false if a write got in the way, {value} is left alone then
+  // {version} tells the writes apart (it changes with every store())
+  bool load(T& value, unsigned& version) const {
+    unsigned sequence = sequence_.load(std::memory_order_acquire);
+    if (sequence % 2 != 0)
+      return false;
+
+    std::array<std::uint64_t, WORDS> words;
+    for (size_t i = 0; i < WORDS; ++i) {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != sequence)
+      return false;
+
+    std::memcpy(&value, words.data(), sizeof(T));
+    version = sequence;
+    return true;
+  }
+
+private:
+  static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+
+  std::atomic<unsigned> sequence_{0};
+  std::array<std::atomic<std::uint64_t>, WORDS> words_{};
+};
+
+}  // namespace Sequencer
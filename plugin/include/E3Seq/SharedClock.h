@@ -0,0 +1,64 @@
+#pragma once
+#include "E3Seq/SeqLock.h"
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/*
+  one tick timeline for several sequencers (instances in one host, or plugins
+  in several processes on one machine)
+
+  a leader publishes where its timeline is: the tick playing at a time, the
+  tempo there and whether it is playing. followers line their own timeline up
+  with the latest one published, the same way as with a host position (see
+  E3Sequencer::setSharedClock()), so every instance stamps a tick with the
+  same time instead of each running off its own timer and start time
+
+  times are seconds on juce::Time::getMillisecondCounterHiRes(), which is the
+  same monotonic clock for every process on a machine
+
+  the clock is plain memory made of lock-free atomics (a SeqLock), so it can
+  be put in a memory mapped file shared between processes. all zero is a
+  valid, stopped clock, so a new file needs no setting up. there is one
+  writer: one leader per clock (an instance or a small daemon), like one
+  master on a MIDI clock line, and one thread of it. two publishes at once
+  would leave the clock unreadable for every process until the file is made
+  again, so a leading E3Sequencer publishes from its tick thread only, also
+  when it is started or stopped from another thread
+*/
+
+namespace Sequencer {
+
+struct SharedClock {
+  struct Position {
+    double tick;  // since the start of the pattern
+    double time;  // at which {tick} plays
+    double bpm;   // at {tick}
+    bool playing;
+  };
+
+  // from one thread of the leader only
+  void publish(const Position& position) { position_.store(position); }
+
+  // false if nothing new was published since {version} (which is then
+  // updated), or a publish got in the way
+  bool read(Position& position, unsigned& version) const {
+    Position latest;
+    unsigned latest_version;
+    if (!position_.load(latest, latest_version) || latest_version == version)
+      return false;
+    position = latest;
+    version = latest_version;
+    return true;
+  }
+
+  SeqLock<Position> position_;
+};
+
+// shared between processes, the layout must not depend on anything but the
+// struct itself
+static_assert(std::is_standard_layout_v<SharedClock>);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+              std::atomic<unsigned>::is_always_lock_free);
+
+}  // namespace Sequencer
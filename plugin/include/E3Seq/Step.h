@@ -1,6 +1,10 @@
 #pragma once
+#include "E3Seq/Config.h"
 #include <cmath>      // std::abs
 #include <algorithm>  // std::sort
+#include <array>
+#include <bit>
+#include <cstdint>
 
 #define DEFAULT_NOTE 60  // C4
 #define DISABLED_NOTE 20
@@ -8,41 +12,56 @@
 #define DEFAULT_VELOCITY 100  // 1..127 since 0 is the same as NoteOff
 #define DEFAULT_LENGTH 0.75f
 
-#define POLYPHONY 4  // make this a static const member of PolyStep
-
 namespace Sequencer {
 
-struct Note {
+// micro-timing is kept in ticks of the config's resolution (see Config.h for
+// the conversions from/to the float step values used by parameters)
+template <typename Config>
+struct BasicNote {
+  static constexpr int DEFAULT_LENGTH_TICKS =
+      Config::lengthToTicks(DEFAULT_LENGTH);
+
   int number = DEFAULT_NOTE;  // for now we use the convention that note number
                               // <= 20 indicates disabled
   int velocity = DEFAULT_VELOCITY;
-  float offset = 0.f;             // relative the step index
-  float length = DEFAULT_LENGTH;  // in (0, TrackLength]
+  int offset_ticks = 0;  // relative the step index, in [-half step, half step)
+  int length_ticks = DEFAULT_LENGTH_TICKS;  // in (0, TrackLength]
 
   void reset() {
     number = DISABLED_NOTE;
     velocity = DEFAULT_VELOCITY;
-    offset = 0.f;  // relative the step index
-    length = DEFAULT_LENGTH;
+    offset_ticks = 0;  // relative the step index
+    length_ticks = DEFAULT_LENGTH_TICKS;
   }
+
+  bool operator==(const BasicNote&) const = default;
 };
 
-struct MonoStep {
+template <typename Config>
+struct BasicMonoStep {
   bool enabled = false;
-  Note note;
+  BasicNote<Config> note;
 
-  float retrigger_rate = 0.f;  // 0 (and minus values) means no retrigger
+  int retrigger_ticks = 0;  // 0 (and minus values) means no retrigger
   float probability = 1.f;
   int alternate = 1;
   int count = 0;
+
+  bool operator==(const BasicMonoStep&) const = default;
 };
 
 // TODO: poly step is a bit more complicated, so it needs to have better
 // encapsulation
-struct PolyStep {
+// the number of voices comes from the config (Config::polyphony, up to 32)
+template <typename Config>
+struct BasicPolyStep {
+  using Note = BasicNote<Config>;
+  static constexpr int polyphony = Config::polyphony;
+  static_assert(polyphony <= 32, "voices are searched with 32 bit masks");
+
   bool enabled = false;
   float probability = 1.0;  // should you keep this?
-  Note notes[POLYPHONY];
+  Note notes[polyphony];
 
   void reset() {
     enabled = false;
@@ -53,18 +72,27 @@ struct PolyStep {
     notes[0].number = DEFAULT_NOTE;
   }
 
+  // highest note first, disabled and stolen notes last
   void sort() {
-    std::sort(&notes[0], &notes[POLYPHONY],
+    std::sort(&notes[0], &notes[polyphony],
               [](const Note& a, const Note& b) { return a.number > b.number; });
   }
 
+  bool isSorted() const {
+    bool sorted = true;
+    for (int i = 1; i < polyphony; ++i) {
+      sorted &= notes[i - 1].number >= notes[i].number;
+    }
+    return sorted;
+  }
+
   void align(int velocity = DEFAULT_VELOCITY,
-             float offset = 0.f,
-             float length = DEFAULT_LENGTH) {
+             int offset_ticks = 0,
+             int length_ticks = Note::DEFAULT_LENGTH_TICKS) {
     for (auto& note : notes) {
       note.velocity = velocity;
-      note.offset = offset;
-      note.length = length;
+      note.offset_ticks = offset_ticks;
+      note.length_ticks = length_ticks;
     }
   }
 
@@ -78,6 +106,51 @@ struct PolyStep {
     return is_empty;
   }
 
+  // MARK: voice search
+  // the note numbers are copied into one lane per voice, and every search is
+  // a branchless pass over the lanes that yields a bit per voice, so the
+  // compiler can vectorise it for any number of voices
+  using VoiceMask = uint32_t;
+  using Lanes = std::array<int, polyphony>;
+
+  Lanes getNumberLanes() const {
+    Lanes lanes;
+    for (int i = 0; i < polyphony; ++i) {
+      lanes[i] = notes[i].number;
+    }
+    return lanes;
+  }
+
+  static VoiceMask findEqual(const Lanes& lanes, int number) {
+    VoiceMask mask = 0;
+    for (int i = 0; i < polyphony; ++i) {
+      mask |= static_cast<VoiceMask>(lanes[i] == number) << i;
+    }
+    return mask;
+  }
+
+  static VoiceMask findAtMost(const Lanes& lanes, int number) {
+    VoiceMask mask = 0;
+    for (int i = 0; i < polyphony; ++i) {
+      mask |= static_cast<VoiceMask>(lanes[i] <= number) << i;
+    }
+    return mask;
+  }
+
+  // the closest voice to {number}, the last one if several are as close
+  static int findClosest(const Lanes& lanes, int number) {
+    Lanes distance;
+    int closest_distance = 127;
+    for (int i = 0; i < polyphony; ++i) {
+      distance[i] = std::abs(lanes[i] - number);
+      closest_distance = std::min(closest_distance, distance[i]);
+    }
+    VoiceMask closest = findAtMost(distance, closest_distance);
+    return closest != 0 ? 31 - std::countl_zero(closest) : 0;
+  }
+
+  static int first(VoiceMask mask) { return std::countr_zero(mask); }
+
   // MARK: note stealing
   // noteNumber should not be interrupted by this step
   // TODO: take offset into consideration
@@ -86,44 +159,21 @@ struct PolyStep {
     // note stealing policy:
     // replace same note -> occupy vacant(disabled) slot -> replace closest
     // note (if there are 2 closest note just choose a random one)
-    for (auto& note : notes) {
-      if (note.number == noteNumber) {
-        note.number = STOLEN_NOTE;
-        if (isEmpty()) {
-          reset();
-        } else {
-          sort();
-        }
-        return;
-      }
-    }
-
-    for (auto& note : notes) {
-      if (note.number == DISABLED_NOTE) {
-        note.number = STOLEN_NOTE;
-        if (isEmpty()) {
-          reset();
-        } else {
-          sort();
-        }
-        return;
-      }
-    }
-
-    int closest_index = 0;
-    int closest_distance = 127;
-    for (int i = 0; i < POLYPHONY; ++i) {
-      int distance = std::abs(notes[i].number - noteNumber);
-      if (distance <= closest_distance) {
-        closest_distance = distance;
-        closest_index = i;
-      }
-    }
+    auto lanes = getNumberLanes();
+    VoiceMask same = findEqual(lanes, noteNumber);
+    VoiceMask vacant = findEqual(lanes, DISABLED_NOTE);
 
-    notes[closest_index].number = STOLEN_NOTE;
+    int voice = same != 0     ? first(same)
+                : vacant != 0 ? first(vacant)
+                              : findClosest(lanes, noteNumber);
+    bool was_sorted = isSorted();
+    notes[voice].number = STOLEN_NOTE;
 
     if (isEmpty()) {
       reset();
+    } else if (was_sorted) {
+      // a stolen note sorts last, so the order only needs a rotation
+      std::rotate(&notes[voice], &notes[voice + 1], &notes[polyphony]);
     } else {
       sort();
     }
@@ -133,42 +183,57 @@ struct PolyStep {
     if (!enabled) {  // when enabled through live rec
       reset();
       notes[0] = new_note;
-      align(new_note.velocity, new_note.offset, new_note.length);
+      align(new_note.velocity, new_note.offset_ticks, new_note.length_ticks);
       enabled = true;
       return;
     };
 
     // similar to note stealing policy
-    for (auto& note : notes) {
-      if (note.number == new_note.number) {
-        note = new_note;
-        return;
-      }
+    auto lanes = getNumberLanes();
+    VoiceMask same = findEqual(lanes, new_note.number);
+    if (same != 0) {
+      notes[first(same)] = new_note;
+      return;
     }
 
-    for (auto& note : notes) {
-      if (note.number <= DISABLED_NOTE) {  // disabled or stolen
-        note = new_note;
+    VoiceMask vacant = findAtMost(lanes, DISABLED_NOTE);  // or stolen
+    if (vacant != 0) {
+      int voice = first(vacant);
+      bool was_sorted = isSorted();
+      notes[voice] = new_note;
+      if (was_sorted) {
+        insertInOrder(voice);
+      } else {
         sort();
-        return;
-      }
-    }
-
-    int closest_index = 0;
-    int closest_distance = 127;
-    for (int i = 0; i < POLYPHONY; ++i) {
-      int distance = std::abs(notes[i].number - new_note.number);
-      if (distance <= closest_distance) {
-        closest_distance = distance;
-        closest_index = i;
       }
+      return;
     }
 
-    notes[closest_index] = new_note;
+    notes[findClosest(lanes, new_note.number)] = new_note;
     // no need to sort in this case?
   }
 
-  PolyStep() { reset(); }
+  BasicPolyStep() { reset(); }
+
+  bool operator==(const BasicPolyStep&) const = default;
+
+private:
+  // moves the note at {voice} to its place in an otherwise sorted step
+  void insertInOrder(int voice) {
+    Note note = notes[voice];
+    int i = voice;
+    for (; i > 0 && notes[i - 1].number < note.number; --i) {
+      notes[i] = notes[i - 1];
+    }
+    for (; i < polyphony - 1 && notes[i + 1].number > note.number; ++i) {
+      notes[i] = notes[i + 1];
+    }
+    notes[i] = note;
+  }
 };
 
+using Note = BasicNote<DefaultConfig>;
+using MonoStep = BasicMonoStep<DefaultConfig>;
+using PolyStep = BasicPolyStep<DefaultConfig>;
+
 }  // namespace Sequencer
@@ -0,0 +1,159 @@
+#pragma once
+#include "E3Seq/Step.h"
+#include "E3Seq/StepFormat.h"
+#include <array>
+
+/*
+  structure-of-arrays storage for {Length} steps (one page, see PagedSteps.h)
+
+  every step field gets its own contiguous column, so whole-page operations
+  (clearing, scanning a field over many steps, bulk edits) run over plain
+  int/float arrays the compiler can vectorise, instead of striding through
+  padded step structs. a step is gathered into (get) or scattered from (set)
+  the usual MonoStep/PolyStep structs, which stay the interface of the tracks
+
+  the element type of each column comes from StepFormat, so the compact build
+  (E3SEQ_COMPACT_STEPS) also packs the columns into bytes
+
+  only specialised for the mono and poly steps
+*/
+
+namespace Sequencer {
+
+template <typename Step, int Length, bool Compact = E3SEQ_COMPACT_STEPS>
+struct StepColumns;
+
+template <typename Config, int Length, bool Compact>
+struct alignas(64) StepColumns<BasicMonoStep<Config>, Length, Compact> {
+  using Step = BasicMonoStep<Config>;
+  using Format = StepFormat<Config, Compact>;
+
+  std::array<typename Format::NoteNumber, Length> number;
+  std::array<typename Format::Velocity, Length> velocity;
+  std::array<typename Format::Offset, Length> offset_ticks;
+  std::array<typename Format::Length, Length> length_ticks;
+  std::array<typename Format::Length, Length> retrigger_ticks;
+  std::array<typename Format::Probability, Length> probability;
+  std::array<typename Format::Counter, Length> alternate;
+  std::array<typename Format::Counter, Length> count;
+  std::array<bool, Length> enabled;
+
+  float getProbability(int i) const {
+    return Format::unpackProbability(probability[i]);
+  }
+
+  // counts one more pass over step {i}, true if the step plays on this pass
+  // (the count wraps at the alternate value, so it never overflows)
+  bool advanceAlternate(int i) {
+    int current = count[i] % alternate[i];
+    count[i] = static_cast<typename Format::Counter>((current + 1) %
+                                                     alternate[i]);
+    return current == 0;
+  }
+
+  Step get(int i) const {
+    Step step;
+    step.enabled = enabled[i];
+    step.note.number = number[i];
+    step.note.velocity = velocity[i];
+    step.note.offset_ticks = offset_ticks[i];
+    step.note.length_ticks = length_ticks[i];
+    step.retrigger_ticks = retrigger_ticks[i];
+    step.probability = getProbability(i);
+    step.alternate = alternate[i];
+    step.count = count[i];
+    return step;
+  }
+
+  void set(int i, const Step& step) {
+    enabled[i] = step.enabled;
+    number[i] = static_cast<typename Format::NoteNumber>(step.note.number);
+    velocity[i] = static_cast<typename Format::Velocity>(step.note.velocity);
+    offset_ticks[i] =
+        static_cast<typename Format::Offset>(step.note.offset_ticks);
+    length_ticks[i] =
+        static_cast<typename Format::Length>(step.note.length_ticks);
+    retrigger_ticks[i] =
+        static_cast<typename Format::Length>(step.retrigger_ticks);
+    probability[i] = Format::packProbability(step.probability);
+    alternate[i] = static_cast<typename Format::Counter>(step.alternate);
+    count[i] = static_cast<typename Format::Counter>(step.count);
+  }
+
+  void fill(const Step& step) {
+    set(0, step);
+    enabled.fill(enabled[0]);
+    number.fill(number[0]);
+    velocity.fill(velocity[0]);
+    offset_ticks.fill(offset_ticks[0]);
+    length_ticks.fill(length_ticks[0]);
+    retrigger_ticks.fill(retrigger_ticks[0]);
+    probability.fill(probability[0]);
+    alternate.fill(alternate[0]);
+    count.fill(count[0]);
+  }
+};
+
+// note fields are laid out note-major ([note][step]), so one note slot of
+// every step in the page is a single contiguous column
+template <typename Config, int Length, bool Compact>
+struct alignas(64) StepColumns<BasicPolyStep<Config>, Length, Compact> {
+  using Step = BasicPolyStep<Config>;
+  using Format = StepFormat<Config, Compact>;
+  static constexpr int polyphony = Config::polyphony;
+
+  template <typename T>
+  using NoteColumns = std::array<std::array<T, Length>, polyphony>;
+
+  NoteColumns<typename Format::NoteNumber> number;
+  NoteColumns<typename Format::Velocity> velocity;
+  NoteColumns<typename Format::Offset> offset_ticks;
+  NoteColumns<typename Format::Length> length_ticks;
+  std::array<typename Format::Probability, Length> probability;
+  std::array<bool, Length> enabled;
+
+  float getProbability(int i) const {
+    return Format::unpackProbability(probability[i]);
+  }
+
+  Step get(int i) const {
+    Step step;
+    step.enabled = enabled[i];
+    step.probability = getProbability(i);
+    for (int n = 0; n < polyphony; ++n) {
+      step.notes[n].number = number[n][i];
+      step.notes[n].velocity = velocity[n][i];
+      step.notes[n].offset_ticks = offset_ticks[n][i];
+      step.notes[n].length_ticks = length_ticks[n][i];
+    }
+    return step;
+  }
+
+  void set(int i, const Step& step) {
+    enabled[i] = step.enabled;
+    probability[i] = Format::packProbability(step.probability);
+    for (int n = 0; n < polyphony; ++n) {
+      const auto& note = step.notes[n];
+      number[n][i] = static_cast<typename Format::NoteNumber>(note.number);
+      velocity[n][i] = static_cast<typename Format::Velocity>(note.velocity);
+      offset_ticks[n][i] =
+          static_cast<typename Format::Offset>(note.offset_ticks);
+      length_ticks[n][i] =
+          static_cast<typename Format::Length>(note.length_ticks);
+    }
+  }
+
+  void fill(const Step& step) {
+    set(0, step);
+    enabled.fill(enabled[0]);
+    probability.fill(probability[0]);
+    for (int n = 0; n < polyphony; ++n) {
+      number[n].fill(number[n][0]);
+      velocity[n].fill(velocity[n][0]);
+      offset_ticks[n].fill(offset_ticks[n][0]);
+      length_ticks[n].fill(length_ticks[n][0]);
+    }
+  }
+};
+
+}  // namespace Sequencer
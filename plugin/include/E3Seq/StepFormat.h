@@ -0,0 +1,69 @@
+#pragma once
+#include "E3Seq/Config.h"
+#include <cstdint>
+#include <limits>
+
+/*
+  element types of the step storage (StepColumns.h) and the render schedule
+
+  the default format keeps every field as int/float. the compact format
+  (E3SEQ_COMPACT_STEPS, for small hardware targets) stores each field in the
+  narrowest byte-aligned type that holds its range, so reading a field is
+  still a plain load:
+
+    note number, velocity   uint8   0..127
+    offset                  int8    [-ticksPerStep / 2, ticksPerStep / 2)
+    length, retrigger       int16   up to one loop in ticks
+    probability             uint8   0..255 for 0..1
+    alternate and count     uint8
+    render tick             int16   within one loop
+
+  the engine only sees ints and floats, the conversions happen when a step is
+  gathered from or scattered into its page
+*/
+
+namespace Sequencer {
+
+template <typename Config, bool Compact = E3SEQ_COMPACT_STEPS>
+struct StepFormat {
+  using NoteNumber = int;
+  using Velocity = int;
+  using Offset = int;
+  using Length = int;
+  using Probability = float;
+  using Counter = int;
+  using Tick = int;
+
+  static constexpr Probability packProbability(float p) { return p; }
+  static constexpr float unpackProbability(Probability p) { return p; }
+};
+
+template <typename Config>
+struct StepFormat<Config, true> {
+  using NoteNumber = std::uint8_t;
+  using Velocity = std::uint8_t;
+  using Offset = std::int8_t;
+  using Length = std::int16_t;
+  using Probability = std::uint8_t;
+  using Counter = std::uint8_t;
+  using Tick = std::int16_t;
+
+  static_assert(Config::ticksPerStep / 2 <= 128,
+                "offsets do not fit the compact format");
+  static_assert(Config::maxLength * Config::ticksPerStep <
+                    std::numeric_limits<std::int16_t>::max(),
+                "a loop does not fit the compact format");
+
+  static constexpr Probability packProbability(float p) {
+    if (p <= 0.f)
+      return 0;
+    if (p >= 1.f)
+      return 255;
+    return static_cast<Probability>(p * 255.f + 0.5f);
+  }
+  static constexpr float unpackProbability(Probability p) {
+    return static_cast<float>(p) / 255.f;
+  }
+};
+
+}  // namespace Sequencer
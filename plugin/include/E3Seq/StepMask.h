@@ -0,0 +1,154 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+/*
+  one bit per step of a track, e.g. which steps are enabled
+
+  lookups only touch the 64 bit words (at most 4 for a 256 step track), so
+  finding the next set step is a couple of count-trailing-zeros instead of
+  a walk through the steps themselves
+
+  AtomicStepMask collects steps from other threads, for one thread to take
+  them all at once
+*/
+
+namespace Sequencer {
+
+template <int MaxLength>
+class StepMask {
+public:
+  static constexpr int numWords = (MaxLength + 63) / 64;
+
+  void set(int index, bool value) {
+    uint64_t bit = uint64_t{1} << (index % 64);
+    if (value) {
+      words_[index / 64] |= bit;
+    } else {
+      words_[index / 64] &= ~bit;
+    }
+  }
+
+  bool test(int index) const {
+    return (words_[index / 64] >> (index % 64)) & 1;
+  }
+
+  void reset() { words_.fill(0); }
+
+  bool any() const {
+    for (auto word : words_) {
+      if (word != 0)
+        return true;
+    }
+    return false;
+  }
+
+  int count() const {
+    int count = 0;
+    for (auto word : words_) {
+      count += std::popcount(word);
+    }
+    return count;
+  }
+
+  // first set step in [begin, end), -1 if there is none
+  int findFirst(int begin, int end) const {
+    if (begin >= end)
+      return -1;
+    for (int w = begin / 64; w * 64 < end; ++w) {
+      uint64_t word = words_[w];
+      if (w == begin / 64) {
+        word &= ~uint64_t{0} << (begin % 64);
+      }
+      if (word != 0) {
+        int index = w * 64 + std::countr_zero(word);
+        return index < end ? index : -1;
+      }
+    }
+    return -1;
+  }
+
+  // last set step in [begin, end), -1 if there is none
+  int findLast(int begin, int end) const {
+    if (begin >= end)
+      return -1;
+    for (int w = (end - 1) / 64; w >= 0 && w * 64 + 63 >= begin; --w) {
+      uint64_t word = words_[w];
+      if (w == (end - 1) / 64 && end % 64 != 0) {
+        word &= ~(~uint64_t{0} << (end % 64));
+      }
+      if (word != 0) {
+        int index = w * 64 + 63 - std::countl_zero(word);
+        return index >= begin ? index : -1;
+      }
+    }
+    return -1;
+  }
+
+  // the set steps of a {length} step loop, searched from {from} onwards
+  // (wrapping around), so {from} itself is found if it is set
+  // -1 if no step is set
+  int findNext(int from, int length) const {
+    int found = findFirst(from, length);
+    return found >= 0 ? found : findFirst(0, from);
+  }
+
+  // same, searched backwards from {from}
+  int findPrevious(int from, int length) const {
+    int found = findLast(0, from + 1);
+    return found >= 0 ? found : findLast(from + 1, length);
+  }
+
+  // the first {length} steps moved {amount} steps later, wrapping around
+  // (steps from {length} on are dropped)
+  StepMask rotated(int amount, int length) const {
+    amount = ((amount % length) + length) % length;
+    StepMask result;
+    for (int index = findFirst(0, length); index >= 0;
+         index = findFirst(index + 1, length)) {
+      result.set((index + amount) % length, true);
+    }
+    return result;
+  }
+
+  bool operator==(const StepMask&) const = default;
+
+private:
+  template <int>
+  friend class AtomicStepMask;
+
+  std::array<uint64_t, numWords> words_{};
+};
+
+template <int MaxLength>
+class AtomicStepMask {
+public:
+  // from any thread
+  void set(int index) {
+    words_[index / 64].fetch_or(uint64_t{1} << (index % 64));
+  }
+  void add(const StepMask<MaxLength>& steps) {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      if (steps.words_[w] != 0) {
+        words_[w].fetch_or(steps.words_[w]);
+      }
+    }
+  }
+
+  // the steps set so far, cleared in the same go: a step set meanwhile is
+  // either in the result or still set for the next take()
+  StepMask<MaxLength> take() {
+    StepMask<MaxLength> taken;
+    for (size_t w = 0; w < words_.size(); ++w) {
+      taken.words_[w] = words_[w].exchange(0);
+    }
+    return taken;
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, StepMask<MaxLength>::numWords> words_{};
+};
+
+}  // namespace Sequencer
@@ -0,0 +1,184 @@
+#pragma once
+#include <juce_core/juce_core.h>  // juce::int64
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+  tempo over the tick timeline, to convert ticks to seconds and back
+
+  the map is a list of segments, each either at a constant tempo or ramping
+  linearly (in BPM per tick) from its start. every segment keeps the time of
+  its first tick, so converting a tick integrates the tempo over the ticks
+  before it:
+
+    constant   t(x) = t0 + k x / bpm
+    ramp       t(x) = t0 + k / slope * ln((bpm + slope x) / bpm)
+
+  with k the seconds per tick at 1 BPM and x the ticks into the segment
+
+  a tempo change only replaces the map from its tick on, so every tick
+  before it keeps its time, and the ticks after it move as a whole instead
+  of jumping by (ticks since start) * (change of the tick length)
+
+  the segments are kept in a ring of {capacity}, allocated once: a tempo
+  changing on every tick (following a MIDI clock) never makes it grow. the
+  owner sizes it from the history it keeps (see forget()), when it is full
+  anyway the oldest segment is dropped
+*/
+
+namespace Sequencer {
+
+class TempoMap {
+public:
+  static constexpr int DEFAULT_CAPACITY = 32;
+
+  TempoMap(int ticksPerStep, double bpm, int capacity = DEFAULT_CAPACITY)
+      : secondsPerTickAt1Bpm_(15.0 / ticksPerStep),
+        segments_(static_cast<size_t>(std::max(capacity, 2))) {
+    reset(bpm);
+  }
+
+  // one tempo from tick 0 on
+  void reset(double bpm) {
+    first_ = 0;
+    size_ = 0;
+    pushBack(Segment{0, 0.0, bpm, 0.0});
+  }
+
+  // {bpm} from {tick} on (later changes are dropped)
+  // the same tempo as before adds nothing
+  void setTempo(juce::int64 tick, double bpm) {
+    double time = getTime(static_cast<double>(tick));
+    truncate(tick);
+    const Segment& last = back();
+    if (last.slope == 0.0 && last.bpm == bpm)
+      return;
+    append(Segment{tick, time, bpm, 0.0});
+  }
+
+  // from the tempo at {tick} linearly to {bpm} over {length} ticks, then
+  // {bpm} from there on (later changes are dropped)
+  void rampTempo(juce::int64 tick, double bpm, juce::int64 length) {
+    if (length <= 0) {
+      setTempo(tick, bpm);
+      return;
+    }
+    double start_bpm = getBpm(static_cast<double>(tick));
+    double time = getTime(static_cast<double>(tick));
+    truncate(tick);
+    Segment ramp{tick, time, start_bpm,
+                 (bpm - start_bpm) / static_cast<double>(length)};
+    append(ramp);
+    pushBack(Segment{tick + length, timeIn(ramp, static_cast<double>(length)),
+                     bpm, 0.0});
+  }
+
+  double getBpm(double tick) const {
+    const Segment& segment = find(tick);
+    return segment.bpm + segment.slope * (tick - segment.tick);
+  }
+
+  // seconds from tick 0 to {tick}
+  double getTime(double tick) const {
+    const Segment& segment = find(tick);
+    return timeIn(segment, tick - static_cast<double>(segment.tick));
+  }
+
+  // the (fractional) tick at {time} seconds from tick 0
+  double getTick(double time) const {
+    int i = size_ - 1;
+    while (i > 0 && at(i).time > time) {
+      --i;
+    }
+    const Segment& segment = at(i);
+    double elapsed = time - segment.time;
+    double x = segment.slope == 0.0
+                   ? elapsed * segment.bpm / secondsPerTickAt1Bpm_
+                   : segment.bpm *
+                         (std::exp(segment.slope * elapsed /
+                                   secondsPerTickAt1Bpm_) -
+                          1.0) /
+                         segment.slope;
+    return static_cast<double>(segment.tick) + x;
+  }
+
+  // drops the segments that end before {tick}, ticks before it are then
+  // converted at the tempo of the first segment left
+  void forget(juce::int64 tick) {
+    while (size_ > 1 && at(1).tick <= tick) {
+      popFront();
+    }
+  }
+
+  int getNumSegments() const { return size_; }
+
+private:
+  struct Segment {
+    juce::int64 tick;
+    double time;   // seconds from tick 0
+    double bpm;    // at {tick}
+    double slope;  // BPM per tick, 0 for a constant tempo
+  };
+
+  // the segment {tick} lies in (the first one for ticks before the map)
+  // searched from the end, conversions are mostly around the play position
+  const Segment& find(double tick) const {
+    int i = size_ - 1;
+    while (i > 0 && static_cast<double>(at(i).tick) > tick) {
+      --i;
+    }
+    return at(i);
+  }
+
+  double timeIn(const Segment& segment, double ticks) const {
+    if (segment.slope == 0.0)
+      return segment.time + secondsPerTickAt1Bpm_ * ticks / segment.bpm;
+    return segment.time +
+           secondsPerTickAt1Bpm_ / segment.slope *
+               std::log((segment.bpm + segment.slope * ticks) / segment.bpm);
+  }
+
+  // drops everything from {tick} on (but always keeps the first segment)
+  void truncate(juce::int64 tick) {
+    while (size_ > 1 && back().tick >= tick) {
+      --size_;
+    }
+  }
+
+  // replaces the first segment if it does not start before {segment}
+  void append(const Segment& segment) {
+    if (back().tick >= segment.tick) {
+      back() = segment;
+    } else {
+      pushBack(segment);
+    }
+  }
+
+  // the ring, {at(0)} is the oldest segment
+  int capacity() const { return static_cast<int>(segments_.size()); }
+  const Segment& at(int i) const {
+    return segments_[static_cast<size_t>((first_ + i) % capacity())];
+  }
+  Segment& back() {
+    return segments_[static_cast<size_t>((first_ + size_ - 1) % capacity())];
+  }
+  void popFront() {
+    first_ = (first_ + 1) % capacity();
+    --size_;
+  }
+  void pushBack(const Segment& segment) {
+    if (size_ == capacity()) {
+      popFront();
+    }
+    ++size_;
+    back() = segment;
+  }
+
+  const double secondsPerTickAt1Bpm_;
+  std::vector<Segment> segments_;  // sized once
+  int first_ = 0;
+  int size_ = 0;
+};
+
+}  // namespace Sequencer
@@ -1,7 +1,17 @@
 #pragma once
 #include "E3Seq/Step.h"
 #include "E3Seq/KeyboardMonitor.h"
+#include "E3Seq/Rng.h"
+#include "E3Seq/StepMask.h"
+#include "E3Seq/StepFormat.h"
+#include "E3Seq/EventTimeline.h"
 #include <juce_audio_basics/juce_audio_basics.h>  // juce::MidiMessageSequence
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 /*
   core functionality of a one track monophonic sequencer
@@ -16,38 +26,66 @@
   :(
 */
 
-// TODO: make this a static const variable of TRACK
-#define STEP_SEQ_MAX_LENGTH 16  // TODO: test as large as 128
-#define STEP_SEQ_DEFAULT_LENGTH 16
 #define MAX_MOTION_SLOTS 8  // not used now
-#define TICKS_PER_STEP 24   // one step is broken into {TICKS_PER_STEP} ticks
-// note: TICKS_PER_STEP over 24 (96 ppq) makes little sense since tick() need to
-// be called more frequently than 1kHz to achieve such precision
 
 namespace Sequencer {
 
-class Track {
+// speed of a track against the sequencer: {numerator} ticks of the track for
+// every {denominator} ticks of the sequencer
+struct TrackSpeed {
+  int numerator = 1;
+  int denominator = 1;
+
+  bool operator==(const TrackSpeed&) const = default;
+};
+
+// the speeds offered by the plugin (T{t}_SPEED), slowest first
+inline constexpr TrackSpeed TRACK_SPEEDS[] = {
+    {1, 4}, {1, 3}, {1, 2}, {2, 3}, {3, 4}, {1, 1},
+    {4, 3}, {3, 2}, {2, 1}, {3, 1}, {4, 1}};
+inline constexpr int TRACK_SPEED_DEFAULT_INDEX = 5;
+#define TRACK_SPEED_MAX 4
+
+// see Config.h for the available configs
+template <typename Config>
+class BasicTrack {
 public:
+  static constexpr int ticksPerStep = Config::ticksPerStep;
+  static constexpr int maxLength = Config::maxLength;
+  using Note = BasicNote<Config>;
+  using Tick = typename StepFormat<Config>::Tick;
+
+  // the order in which the steps of a loop are played (see setPlayMode())
   enum class PlayMode {
     Forward,
     Backward,
-    Random,
-    Bounce,
-    Brownian
-  };  // unused now
-
-  Track(int channel,
-        const KeyboardMonitor& keyboard,
-        int length = STEP_SEQ_DEFAULT_LENGTH,
-        PlayMode mode = PlayMode::Forward)
+    Random,    // any step, repeats allowed
+    Bounce,    // forward and backward on alternate loops
+    Brownian   // a random walk: one step on, stay, or one step back
+  };
+
+  BasicTrack(int channel,
+             const KeyboardMonitor& keyboard,
+             int length = Config::defaultLength,
+             PlayMode mode = PlayMode::Forward)
       : keyboardRef(keyboard),
         channel_(channel),
         trackLength_(length),
         playMode_(mode),
         enabled_(true),
-        tick_(0) {}
+        seed_(0),
+        seedLocked_(false),
+        tick_(0) {
+    // tracks start without enabled steps
+    renderTicks_.fill(static_cast<Tick>(NOT_RENDERED));
+    reseed();
+    for (int slot = 0; slot < maxLength; ++slot) {
+      order_[slot] = static_cast<OrderIndex>(slot);
+    }
+    previousOrder_ = order_;
+  }
 
-  ~Track() = default;
+  ~BasicTrack() = default;
 
   void setEnabled(bool enabled) { enabled_ = enabled; }
 
@@ -60,35 +98,200 @@ public:
     plays nicely in sync
     will revisit this when I start implement polymeter
   */
-  void setLength(int length) { trackLength_ = length; }
+  // also allocates the step storage up to {length} (so call this from the
+  // message thread, not the audio thread)
+  void setLength(int length) {
+    if (length != trackLength_) {
+      reserveSteps(length);
+      trackLength_ = length;
+    }
+  }
   int getChannel() const { return channel_; }
   bool getIsEnabled() const { return enabled_; }
   int getLength() const { return trackLength_; }
 
+  // the loop is played in a table order: slot {s} of the loop plays step
+  // order[s], each slot at the time of step {s} going forward. the table is
+  // filled when a loop starts to render (from the track's generator for
+  // Random and Brownian, so a locked seed replays the order as well), and
+  // rendering, lookahead and the play position only look steps up in it
+  // may be called from any thread, it is taken over with the next loop
+  void setPlayMode(PlayMode mode) { playMode_.store(mode); }
+  PlayMode getPlayMode() const { return playMode_.load(); }
+
+  // the even numbered slots (the 2nd, 4th, ... step played) are delayed by
+  // {ticks}, at most half a step (see Config::swingToTicks()). retriggers
+  // stay on the straight grid
+  // may be called from any thread, it is taken over with the next loop
+  // together with the play order
+  void setSwing(int ticks) {
+    swing_.store(std::clamp(ticks, 0, HALF_STEP_TICKS));
+  }
+  int getSwing() const { return swing_.load(); }
+
   // caller should register a callback to receive MIDI messages
+  // (time stamped with the sequencer tick, counted from returnToStart(), at
+  // which they are meant to be heard, see setDelay(). fractional when the
+  // track runs at another speed)
   std::function<void(juce::MidiMessage msg)> sendMidiMessage;
 
-  // this function should be called (on average) {TICKS_PER_STEP} times per step
+  // this function should be called (on average) {ticksPerStep} times per step
   // some amount of time jittering should be fine
+  // each call is one sequencer tick, the track plays as many of its own
+  // ticks as its speed makes due (see setSpeed())
   void tick();
 
   void returnToStart();  // for resync
 
+  // moves the play position to sequencer tick {tick} (as if every loop so
+  // far had the current length and speed) without playing what is in between
+  // the notes still on are ended right away
+  void locate(juce::int64 tick);
+
   int getCurrentStepIndex() const;  // exposed to GUI to show play position
 
+  // the step at sequencer tick {tick} (the timeline of sendMidiMessage),
+  // counted from the play position, so it is right across jumps and length
+  // changes
+  int getStepIndexAt(juce::int64 tick) const;
+
+  // the (fractional) tick of the track at sequencer tick {tick}
+  double getTrackTick(double tick) const {
+    return static_cast<double>(anchorTrack_) +
+           (tick - static_cast<double>(anchorTick_)) * speed_.numerator /
+               speed_.denominator;
+  }
+
+  // the track plays {speed} of the sequencer's ticks: a budget gains the
+  // numerator every sequencer tick and pays the denominator for every track
+  // tick, so no extra ticks are needed and the ratio stays exact
+  // the denominator must divide ticksPerStep (a sequencer step is then a
+  // whole number of track ticks), speeds up to TRACK_SPEED_MAX
+  // may be called from any thread, tick() takes it over at the play position
+  void setSpeed(TrackSpeed speed) {
+    jassert(speed.numerator > 0 && speed.denominator > 0);
+    jassert(ticksPerStep % speed.denominator == 0);
+    jassert(speed.numerator <= TRACK_SPEED_MAX * speed.denominator);
+    requestedSpeed_.store(speed);
+  }
+  TrackSpeed getSpeed() const { return requestedSpeed_.load(); }
+
+  // how a track at another speed keeps in line with the rest
+  // Free: it runs on from the start at its own speed
+  // MasterLoop: it starts its loop over at every master loop (see
+  // setMasterLoop()), wherever it is
+  enum class SyncMode { Free, MasterLoop };
+  void setSyncMode(SyncMode mode) { syncMode_.store(mode); }
+  SyncMode getSyncMode() const { return syncMode_.load(); }
+  // in sequencer ticks, a whole number of steps and at least one step of the
+  // track at its slowest (set by the sequencer)
+  void setMasterLoop(int ticks) {
+    jassert(ticks % ticksPerStep == 0 && ticks >= ticksPerStep * 4);
+    masterLoop_.store(ticks);
+  }
+
+  // steps are rendered {ticks} ahead of the play position (less than one
+  // loop), and their events are sent up to SEND_AHEAD_TICKS of that before
+  // they play, stamped with when they play (see OutputQueue.h), so a tick()
+  // up to that late does not make a late note. a step edited after it was
+  // rendered ahead (see markEdited()) is rendered again, as long as none of
+  // it has been sent
+  void setLookahead(int ticks) { lookaheadTicks_.store(std::max(ticks, 0)); }
+  int getLookahead() const { return lookaheadTicks_.load(); }
+
+  // latency compensation: events are sent {ticks} (sequencer ticks) later
+  // than they are written (earlier if negative), and stamped accordingly. a
+  // negative delay makes the steps render that much further ahead on top of
+  // the lookahead. from the tick thread (see E3Sequencer::setTrackDelay())
+  void setDelay(int ticks) {
+    delayTicks_ = ticks;
+    updateTrackDelay();
+  }
+  int getDelay() const { return delayTicks_; }
+
+  // the step at the render position (where note stealing happens)
+  int getRenderStepIndex() const {
+    return order_[(renderTick_ + HALF_STEP_TICKS) / ticksPerStep];
+  }
+
+  // tick (relative to the loop start) at which step {index} is rendered, or
+  // NOT_RENDERED if the step is disabled
+  // this is a lookup in the render schedule, so the GUI and any lookahead can
+  // ask as often as they like
+  static constexpr int NOT_RENDERED = std::numeric_limits<Tick>::min();
+  int getStepRenderTick(int index) const { return renderTicks_[index]; }
+
+  // which steps are enabled, kept together with the render schedule
+  const StepMask<maxLength>& getEnabledSteps() const { return enabledSteps_; }
+
+  // probability is drawn from a per-track generator seeded with {seed} (mixed
+  // with the channel so tracks sharing a seed are still independent)
+  // the generator restarts from the seed on returnToStart(), so playback from
+  // the start is reproducible. with the seed locked it also restarts at every
+  // loop, so probabilistic patterns replay identically each time
+  // a new seed is picked up by the tick thread at the next loop (the
+  // generator is only ever touched there)
+  void setSeed(uint32_t seed) { seed_.store(seed); }
+  void setSeedLocked(bool locked) { seedLocked_.store(locked); }
+  uint32_t getSeed() const { return seed_.load(); }
+  bool getIsSeedLocked() const { return seedLocked_.load(); }
+
   // TODO: track utilities (randomize, humanize, rotate, Euclidean, Grids,
   // etc.)
 
 protected:
   void renderNote(int index, Note note);
 
-  // timestamp in ticks (not seconds or samples)
+  // render schedule: derived classes call scheduleStep() whenever a step is
+  // written, with the earliest offset of the step, so tick() never has to
+  // look into the steps themselves
+  void scheduleStep(int index, bool enabled, int offset_ticks) {
+    renderTicks_[index] = static_cast<Tick>(
+        enabled ? index * ticksPerStep + offset_ticks : NOT_RENDERED);
+    enabledSteps_.set(index, enabled);
+  }
+  // for steps rendered in parts: renderPending({tick}) is called at {tick}
+  // (within the current step), NOT_RENDERED cancels
+  void schedulePending(int tick) { pendingTick_ = tick; }
+
+  void unscheduleAllSteps() {
+    // whatever was enabled may have been rendered ahead
+    editedSteps_.add(enabledSteps_);
+    renderTicks_.fill(static_cast<Tick>(NOT_RENDERED));
+    enabledSteps_.reset();
+  }
+
+  // derived classes call markEdited() when the content of a step changes
+  // (not on every write of the same step), so a step that was already
+  // rendered ahead is rendered again
+  void markEdited(int index) { editedSteps_.set(index); }
+
+  // timestamp in ticks relative to the current loop (not seconds or samples)
+  // it may lie any number of loops ahead
+  // (as if the step being rendered was in its own place, see setPlayMode())
   void renderMidiMessage(juce::MidiMessage message);
+  // the timeline has a fixed size and drops what does not fit: a note is
+  // only rendered if its note off fits as well (see EventTimeline)
+  bool hasRoomFor(int numEvents) const {
+    return events_.getNumFree() >= numEvents;
+  }
+
+  // note on tick of the next enabled step in play order after the one being
+  // rendered (within a loop, on the same terms as renderMidiMessage()), or
+  // NOT_RENDERED if there is none. Forward, Backward and Bounce look it up in
+  // the enabled steps, Random and Brownian walk their table. for those the
+  // order after this loop is not drawn yet, it is taken to repeat
+  int getNextNoteOnTick() const;
+
+  // the swing of the step being rendered, in ticks
+  int getRenderSwing() const { return renderSwing_; }
 
   // for note stealing
   const KeyboardMonitor& keyboardRef;
 
-  static constexpr int HALF_STEP_TICKS = TICKS_PER_STEP / 2;
+  Rng rng_;
+
+  static constexpr int HALF_STEP_TICKS = ticksPerStep / 2;
 
 private:
   int channel_;
@@ -96,30 +299,187 @@ private:
   // track parameters as seen by the user
 
   int trackLength_;
-  [[maybe_unused]] PlayMode playMode_;
-  // TODO: implement swing (should not affect roll)
-  [[maybe_unused]] float swing_;
-  [[maybe_unused]] bool resync_to_longest_track_;  // or master length?
+  std::atomic<PlayMode> playMode_;
+  std::atomic<int> swing_{0};
+
+  std::atomic<TrackSpeed> requestedSpeed_{TrackSpeed{}};
+  std::atomic<SyncMode> syncMode_{SyncMode::Free};
+  std::atomic<int> masterLoop_{Config::defaultLength * ticksPerStep};
 
   bool enabled_;
 
+  std::atomic<uint32_t> seed_;
+  std::atomic<bool> seedLocked_;
+  uint32_t rngSeed_ = 0;  // the seed the generator last restarted from
+
   // function related variables
-  int tick_;
+  int tick_;  // play position within the loop, wraps
+  // ticks since returnToStart(), never wraps (timeline of the MIDI events)
+  // these are ticks of the track, see setSpeed()
+  juce::int64 absoluteTick_ = 0;
 
-  // derived class must implement renderStep and getStepNoteRenderTick
-  virtual void renderStep(int index) = 0;
-  virtual int getStepRenderTick(int index) const = 0;
+  // speed: track tick {anchorTrack_} plays at sequencer tick {anchorTick_},
+  // the ones after it every denominator / numerator sequencer ticks. the
+  // anchor moves when the speed changes and at every master loop
+  TrackSpeed speed_;
+  juce::int64 sequencerTick_ = 0;  // sequencer ticks since returnToStart()
+  juce::int64 anchorTick_ = 0;
+  juce::int64 anchorTrack_ = 0;
+  int budget_ = 0;  // in (-denominator, 0] between two sequencer ticks
+  int resyncTicks_ = 0;  // master loop in sequencer ticks, 0 when free
+  // the next master loop the render position starts the loop over at, in
+  // sequencer ticks and in ticks of the track
+  static constexpr juce::int64 NO_RESYNC =
+      std::numeric_limits<juce::int64>::max();
+  juce::int64 renderResyncTick_ = NO_RESYNC;
+  juce::int64 renderResyncTrack_ = NO_RESYNC;
+  int trackDelay_ = 0;  // the delay in ticks of the track
 
-  /*
-    double MIDI buffer inspired by the endless scrolling background technique in
-    early arcade games
-    invariant: MIDI messages are always sorted by timestamp
-    note: when porting to Spark/Prologue, change from juce::MidiMessageSequence
-    to a more performant data structure
-  */
+  // the render position runs {lookaheadTicks_} ahead of the play position
+  // {loopStart_} is the absolute tick of tick 0 of its loop, and
+  // {previousLoopStart_} of the loop before (where the play position may
+  // still be)
+  std::atomic<int> lookaheadTicks_{0};
+  // a quarter step, more than the jitter of a timer, less than most of what
+  // could still be edited
+  static constexpr int SEND_AHEAD_TICKS = ticksPerStep / 4;
+  int delayTicks_ = 0;
+  int renderTick_ = 0;
+  juce::int64 loopStart_ = 0;
+  juce::int64 previousLoopStart_ = 0;
+  // loop and step being rendered, events are tagged with the step (with the
+  // tick of its slot, see setPlayMode())
+  juce::int64 renderLoopStart_ = 0;
+  EventTimeline::Tag renderingStep_ = 0;
+  // the last one renderAt() started, so a step is rendered once per slot
+  static constexpr EventTimeline::Tag NO_STEP =
+      std::numeric_limits<EventTimeline::Tag>::min();
+  EventTimeline::Tag renderedStep_ = NO_STEP;
+
+  std::array<Tick, maxLength> renderTicks_;
 
-  juce::MidiMessageSequence firstRun_;
-  juce::MidiMessageSequence secondRun_;
+  // play order (see setPlayMode()) of the loop at {loopStart_} and of the one
+  // before, filled with {orderMode_} and swung by {orderSwing_}. the step
+  // being rendered is in slot {renderSlot_} (of the loop before if
+  // {renderInPreviousLoop_}), moved by {renderShift_} ticks from its own
+  // place, swing included
+  using OrderIndex = std::uint16_t;
+  using Order = std::array<OrderIndex, maxLength>;
+  Order order_;
+  Order previousOrder_;
+  PlayMode orderMode_ = PlayMode::Forward;
+  // how each table runs: through the steps either way (a lookup in
+  // {enabledSteps_} finds the next one), or drawn (only the table knows)
+  enum class Direction { Forward, Backward, Drawn };
+  Direction orderDirection_ = Direction::Forward;
+  Direction previousDirection_ = Direction::Forward;
+  int orderSwing_ = 0;
+  int previousSwing_ = 0;
+  bool bounceBackward_ = false;
+  int walk_ = 0;  // the last step of the Brownian walk
+  int renderSlot_ = 0;
+  int renderShift_ = 0;
+  int renderSwing_ = 0;
+  bool renderInPreviousLoop_ = false;
+  bool playInPreviousLoop_ = false;  // (of the play position)
+
+  // the order of the next loop, from step 0 again if {restart}
+  void fillOrder(bool restart);
+
+  // restart the generator from the requested seed if it changed, or anyway
+  // with {restart}
+  void applySeed(bool restart);
+  void reseed() {
+    rng_.setSeed((static_cast<uint64_t>(rngSeed_) << 32) |
+                 static_cast<uint32_t>(channel_));
+  }
+  const Order& getPlayOrder() const {
+    return playInPreviousLoop_ ? previousOrder_ : order_;
+  }
+  // ticks from the place of step {index} to the time of slot {slot}
+  static int getSlotShift(int slot, int index, int swing) {
+    return (slot - index) * ticksPerStep + (slot % 2 == 1 ? swing : 0);
+  }
+  // the step in {slot} of a table running in {direction}
+  int getSlotStep(const Order& order, Direction direction, int slot) const {
+    switch (direction) {
+      case Direction::Forward:
+        return slot;
+      case Direction::Backward:
+        return trackLength_ - 1 - slot;
+      case Direction::Drawn:
+        break;
+    }
+    return order[static_cast<size_t>(slot)];
+  }
+  // the first slot in [begin, end) of that table with an enabled step, -1 if
+  // there is none
+  int findEnabledSlot(const Order& order,
+                      Direction direction,
+                      int begin,
+                      int end) const;
+  void setRenderSlot(juce::int64 loopStart,
+                     int slot,
+                     int index,
+                     bool previous) {
+    renderLoopStart_ = loopStart;
+    renderingStep_ = loopStart + slot * ticksPerStep;
+    renderSlot_ = slot;
+    int swing = previous ? previousSwing_ : orderSwing_;
+    renderSwing_ = slot % 2 == 1 ? swing : 0;
+    renderShift_ = getSlotShift(slot, index, swing);
+    renderInPreviousLoop_ = previous;
+  }
+
+  StepMask<maxLength> enabledSteps_;
+  // marked from the message thread, taken by the tick thread
+  AtomicStepMask<maxLength> editedSteps_;
+  int pendingTick_ = NOT_RENDERED;
+
+  // the events of the play position are sent here (shifted by the delay),
+  // the ones up to {getSendAhead()} after it have been sent as well
+  juce::int64 getSendTick() const { return absoluteTick_ - trackDelay_; }
+  int getSendAhead() const {
+    return std::min(lookaheadTicks_.load(), SEND_AHEAD_TICKS);
+  }
+  void sendEvent(const juce::MidiMessage& message);
+
+  // one tick of the track
+  void advance();
+  void applySpeed();
+  // track tick {track} plays at sequencer tick {tick}, the ticks before it
+  // are played right away if they are behind
+  void anchor(juce::int64 tick, juce::int64 track);
+  // the track tick played first at or after sequencer tick {tick}
+  juce::int64 getTrackTickAt(juce::int64 tick) const {
+    return anchorTrack_ +
+           ((tick - anchorTick_) * speed_.numerator + speed_.denominator - 1) /
+               speed_.denominator;
+  }
+  double getSequencerTick(juce::int64 track) const {
+    return static_cast<double>(anchorTick_) +
+           static_cast<double>(track - anchorTrack_) * speed_.denominator /
+               speed_.numerator;
+  }
+  void updateTrackDelay() {
+    trackDelay_ = static_cast<int>(std::lround(
+        static_cast<double>(delayTicks_) * speed_.numerator /
+        speed_.denominator));
+  }
+  void scheduleResync(juce::int64 tick);
+
+  void renderAt(int tick);
+  void advanceRenderTick();
+  void rerenderEditedSteps(const StepMask<maxLength>& edited);
+
+  // derived class must implement renderStep and reserveSteps
+  virtual void renderStep(int index) = 0;
+  virtual void renderPending(int tick) { juce::ignoreUnused(tick); }
+  virtual void reserveSteps(int length) = 0;
+
+  EventTimeline events_;
 };
 
+using Track = BasicTrack<DefaultConfig>;
+
 }  // namespace Sequencer
\ No newline at end of file
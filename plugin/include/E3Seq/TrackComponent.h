@@ -10,6 +10,56 @@ namespace audio_plugin {
 #define KNOB_HEIGHT 90
 #define KNOB_TEXT_HEIGHT 20
 
+#define PAGE_CONTROL_WIDTH (STEP_BUTTON_WIDTH * 2)
+
+// page selector and length of one track, right of the step buttons
+// the step widgets always edit the {STEP_SEQ_PAGE_LENGTH} steps of the
+// selected page, the processor swaps the step parameters when it changes
+class TrackPageControls : public juce::Component {
+public:
+  static constexpr int WIDTH = PAGE_CONTROL_WIDTH * 2 + STEP_BUTTON_SPACING;
+
+  TrackPageControls(AudioPluginAudioProcessor& p, int trackIndex)
+      : pagePointer(p.parameters.getRawParameterValue(
+            "T" + juce::String(trackIndex) + "_PAGE")) {
+    juce::String prefix = "T" + juce::String(trackIndex) + "_";
+
+    pageSlider.setSliderStyle(juce::Slider::IncDecButtons);
+    pageSlider.setTextBoxStyle(juce::Slider::TextBoxLeft, false,
+                               STEP_BUTTON_WIDTH, STEP_BUTTON_HEIGHT);
+    pageSlider.setTooltip("steps shown and edited below");
+    addAndMakeVisible(pageSlider);
+
+    lengthSlider.setSliderStyle(juce::Slider::IncDecButtons);
+    lengthSlider.setTextBoxStyle(juce::Slider::TextBoxLeft, false,
+                                 STEP_BUTTON_WIDTH, STEP_BUTTON_HEIGHT);
+    lengthSlider.setTooltip("track length in steps");
+    addAndMakeVisible(lengthSlider);
+
+    pageAttachment = std::make_unique<SliderAttachment>(
+        p.parameters, prefix + "PAGE", pageSlider);
+    lengthAttachment = std::make_unique<SliderAttachment>(
+        p.parameters, prefix + "TRACK_LENGTH", lengthSlider);
+  }
+
+  int getPage() const { return static_cast<int>(*pagePointer); }
+
+  void resized() override final {
+    pageSlider.setBounds(0, 0, PAGE_CONTROL_WIDTH, STEP_BUTTON_HEIGHT);
+    lengthSlider.setBounds(PAGE_CONTROL_WIDTH + STEP_BUTTON_SPACING, 0,
+                           PAGE_CONTROL_WIDTH, STEP_BUTTON_HEIGHT);
+  }
+
+private:
+  std::atomic<float>* pagePointer;
+
+  juce::Slider pageSlider;
+  juce::Slider lengthSlider;
+
+  using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+  std::unique_ptr<SliderAttachment> pageAttachment, lengthAttachment;
+};
+
 // TODO: refactor to reduce code duplication
 
 class MonoTrackComponent : public juce::Component, private juce::Timer {
@@ -19,8 +69,10 @@ public:
                      juce::Colour trackColor)
       : processorRef(p),
         trackRef(p.sequencer.getMonoTrack(trackIndex)),
-        trackIndex_(trackIndex) {
+        trackIndex_(trackIndex),
+        pageControls(p, trackIndex) {
     startTimer(10);
+    addAndMakeVisible(pageControls);
 
     setCollapsed(true);
     addAndMakeVisible(trackCollapseButton);
@@ -32,7 +84,7 @@ public:
     };
 
     // step buttons
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       stepButtons[i].setButtonText(juce::String(i + 1));
       stepButtons[i].setClickingTogglesState(true);
       stepButtons[i].setColour(juce::TextButton::ColourIds::buttonOnColourId,
@@ -56,7 +108,7 @@ public:
     noteLabel.setText("note", juce::NotificationType::dontSendNotification);
     addAndMakeVisible(noteLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       noteKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       noteKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                    STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -67,7 +119,7 @@ public:
     velocityLabel.setText("velocity",
                           juce::NotificationType::dontSendNotification);
     addAndMakeVisible(velocityLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       velocityKnobs[i].setSliderStyle(juce::Slider::LinearVertical);
       velocityKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                        STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -77,7 +129,7 @@ public:
     // offset
     offsetLabel.setText("offset", juce::NotificationType::dontSendNotification);
     addAndMakeVisible(offsetLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       offsetKnobs[i].setSliderStyle(juce::Slider::LinearHorizontal);
       offsetKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                      STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -87,7 +139,7 @@ public:
     // length
     lengthLabel.setText("length", juce::NotificationType::dontSendNotification);
     addAndMakeVisible(lengthLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       lengthKnobs[i].setSliderStyle(juce::Slider::LinearHorizontal);
       lengthKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                      STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -98,7 +150,7 @@ public:
     retriggerLabel.setText("retrigger",
                            juce::NotificationType::dontSendNotification);
     addAndMakeVisible(retriggerLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       retriggerKnobs[i].setSliderStyle(juce::Slider::LinearHorizontal);
       retriggerKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                         STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -109,7 +161,7 @@ public:
     probabilityLabel.setText("probability",
                              juce::NotificationType::dontSendNotification);
     addAndMakeVisible(probabilityLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       probabilityKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       probabilityKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                           STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -120,7 +172,7 @@ public:
     alternateLabel.setText("alternate",
                            juce::NotificationType::dontSendNotification);
     addAndMakeVisible(alternateLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       alternateKnobs[i].setSliderStyle(juce::Slider::LinearVertical);
       alternateKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                         STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -129,7 +181,7 @@ public:
     }
 
     // attach buttons and sliders to processor parameters
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       juce::String prefix =
           "T" + juce::String(trackIndex_) + "_S" + juce::String(i) + "_";
 
@@ -161,13 +213,27 @@ public:
 
   // TODO: try some async animation stuff?
   void timerCallback() override final {
-    int playhead_index = trackRef.getCurrentStepIndex();
+    int page = pageControls.getPage();
+    if (page != shownPage_) {
+      shownPage_ = page;
+      for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
+        stepButtons[i].setButtonText(
+            juce::String(page * STEP_SEQ_PAGE_LENGTH + i + 1));
+      }
+    }
+
+    // relative to the first step of the shown page
+    int playhead_index =
+        trackRef.getCurrentStepIndex() - page * STEP_SEQ_PAGE_LENGTH;
+    int track_end = trackRef.getLength() - page * STEP_SEQ_PAGE_LENGTH;
 
-    for (int i = 0; i < STEP_SEQ_MAX_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       if (i == playhead_index) {
         stepButtons[i].setAlpha(1.f);
-      } else {
+      } else if (i < track_end) {
         stepButtons[i].setAlpha(0.7f);
+      } else {
+        stepButtons[i].setAlpha(0.3f);  // past the end of the track
       }
     }
   }
@@ -175,6 +241,9 @@ public:
   void resized() override final {
     // layout
     trackCollapseButton.setBounds(0, 0, STEP_BUTTON_WIDTH, STEP_BUTTON_HEIGHT);
+    pageControls.setBounds(
+        (STEP_SEQ_PAGE_LENGTH + 1) * (STEP_BUTTON_WIDTH + STEP_BUTTON_SPACING),
+        0, TrackPageControls::WIDTH, STEP_BUTTON_HEIGHT);
     noteLabel.setBounds(0, STEP_BUTTON_HEIGHT, STEP_BUTTON_WIDTH, KNOB_HEIGHT);
     velocityLabel.setBounds(0, STEP_BUTTON_HEIGHT + KNOB_HEIGHT * 1,
                             STEP_BUTTON_WIDTH, KNOB_HEIGHT);
@@ -189,7 +258,7 @@ public:
     alternateLabel.setBounds(0, STEP_BUTTON_HEIGHT + KNOB_HEIGHT * 6,
                              STEP_BUTTON_WIDTH, KNOB_HEIGHT);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       int x = (i + 1) * (STEP_BUTTON_WIDTH + STEP_BUTTON_SPACING);
       stepButtons[i].setBounds(x, 0, STEP_BUTTON_WIDTH, STEP_BUTTON_HEIGHT);
       noteKnobs[i].setBounds(x, STEP_BUTTON_HEIGHT, STEP_BUTTON_WIDTH,
@@ -219,18 +288,23 @@ private:
   Sequencer::Track& trackRef;
   int trackIndex_;
   bool collapsed_;
+  int shownPage_ = 0;
+
+  TrackPageControls pageControls;
 
   void setCollapsed(bool collapsed) {
     collapsed_ = collapsed;
     if (collapsed) {
-      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_DEFAULT_LENGTH + 1) +
-                  STEP_BUTTON_SPACING * STEP_SEQ_DEFAULT_LENGTH,
+      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  STEP_BUTTON_SPACING * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  TrackPageControls::WIDTH,
               STEP_BUTTON_HEIGHT);
       trackCollapseButton.setButtonText("Track " +
                                         juce::String(trackIndex_ + 1) + " ▶");
     } else {
-      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_DEFAULT_LENGTH + 1) +
-                  STEP_BUTTON_SPACING * STEP_SEQ_DEFAULT_LENGTH,
+      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  STEP_BUTTON_SPACING * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  TrackPageControls::WIDTH,
               STEP_BUTTON_HEIGHT + KNOB_HEIGHT * 7);
       trackCollapseButton.setButtonText("Track " +
                                         juce::String(trackIndex_ + 1) + " ▼");
@@ -246,27 +320,27 @@ private:
   juce::Label probabilityLabel;
   juce::Label alternateLabel;
 
-  juce::TextButton stepButtons[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider noteKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider lengthKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider velocityKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider offsetKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider retriggerKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider probabilityKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider alternateKnobs[STEP_SEQ_DEFAULT_LENGTH];
+  juce::TextButton stepButtons[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider noteKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider lengthKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider velocityKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider offsetKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider retriggerKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider probabilityKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider alternateKnobs[STEP_SEQ_PAGE_LENGTH];
 
   using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
   using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
 
   // Parameter attachments
-  std::unique_ptr<ButtonAttachment> enableAttachments[STEP_SEQ_DEFAULT_LENGTH];
-  std::unique_ptr<SliderAttachment> noteAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      velocityAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      offsetAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      lengthAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      retriggerAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      probabilityAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      alternateAttachments[STEP_SEQ_DEFAULT_LENGTH];
+  std::unique_ptr<ButtonAttachment> enableAttachments[STEP_SEQ_PAGE_LENGTH];
+  std::unique_ptr<SliderAttachment> noteAttachments[STEP_SEQ_PAGE_LENGTH],
+      velocityAttachments[STEP_SEQ_PAGE_LENGTH],
+      offsetAttachments[STEP_SEQ_PAGE_LENGTH],
+      lengthAttachments[STEP_SEQ_PAGE_LENGTH],
+      retriggerAttachments[STEP_SEQ_PAGE_LENGTH],
+      probabilityAttachments[STEP_SEQ_PAGE_LENGTH],
+      alternateAttachments[STEP_SEQ_PAGE_LENGTH];
 };
 
 // MARK: poly track
@@ -277,8 +351,10 @@ public:
                      juce::Colour trackColor)
       : processorRef(p),
         trackRef(p.sequencer.getPolyTrack(trackIndex-STEP_SEQ_NUM_MONO_TRACKS)),
-        trackIndex_(trackIndex) {
+        trackIndex_(trackIndex),
+        pageControls(p, trackIndex) {
     startTimer(10);
+    addAndMakeVisible(pageControls);
 
     setCollapsed(true);
     addAndMakeVisible(trackCollapseButton);
@@ -290,7 +366,7 @@ public:
     };
 
     // step buttons
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       stepButtons[i].setButtonText(juce::String(i + 1));
       stepButtons[i].setClickingTogglesState(true);
       stepButtons[i].setColour(juce::TextButton::ColourIds::buttonOnColourId,
@@ -316,7 +392,7 @@ public:
                          juce::NotificationType::dontSendNotification);
     addAndMakeVisible(noteOneLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       noteOneKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       noteOneKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                       STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -328,7 +404,7 @@ public:
                          juce::NotificationType::dontSendNotification);
     addAndMakeVisible(noteTwoLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       noteTwoKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       noteTwoKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                       STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -340,7 +416,7 @@ public:
                            juce::NotificationType::dontSendNotification);
     addAndMakeVisible(noteThreeLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       noteThreeKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       noteThreeKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                         STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -352,7 +428,7 @@ public:
                           juce::NotificationType::dontSendNotification);
     addAndMakeVisible(noteFourLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       noteFourKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       noteFourKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                        STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -364,7 +440,7 @@ public:
                           juce::NotificationType::dontSendNotification);
     addAndMakeVisible(velocityLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       velocityKnobs[i].setSliderStyle(juce::Slider::LinearVertical);
       velocityKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                        STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -388,7 +464,7 @@ public:
     offsetLabel.setText("offset", juce::NotificationType::dontSendNotification);
     addAndMakeVisible(offsetLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       offsetKnobs[i].setSliderStyle(juce::Slider::LinearHorizontal);
       offsetKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                      STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -412,7 +488,7 @@ public:
     lengthLabel.setText("length", juce::NotificationType::dontSendNotification);
     addAndMakeVisible(lengthLabel);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       lengthKnobs[i].setSliderStyle(juce::Slider::LinearHorizontal);
       lengthKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                      STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -436,7 +512,7 @@ public:
     probabilityLabel.setText("probability",
                              juce::NotificationType::dontSendNotification);
     addAndMakeVisible(probabilityLabel);
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       probabilityKnobs[i].setSliderStyle(juce::Slider::RotaryVerticalDrag);
       probabilityKnobs[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false,
                                           STEP_BUTTON_WIDTH, KNOB_TEXT_HEIGHT);
@@ -444,7 +520,7 @@ public:
     }
 
     // attach buttons and sliders to processor parameters
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       juce::String prefix =
           "T" + juce::String(trackIndex_) + "_S" + juce::String(i) + "_";
 
@@ -478,13 +554,27 @@ public:
   }
 
   void timerCallback() override final {
-    int playhead_index = trackRef.getCurrentStepIndex();
+    int page = pageControls.getPage();
+    if (page != shownPage_) {
+      shownPage_ = page;
+      for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
+        stepButtons[i].setButtonText(
+            juce::String(page * STEP_SEQ_PAGE_LENGTH + i + 1));
+      }
+    }
+
+    // relative to the first step of the shown page
+    int playhead_index =
+        trackRef.getCurrentStepIndex() - page * STEP_SEQ_PAGE_LENGTH;
+    int track_end = trackRef.getLength() - page * STEP_SEQ_PAGE_LENGTH;
 
-    for (int i = 0; i < STEP_SEQ_MAX_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       if (i == playhead_index) {
         stepButtons[i].setAlpha(1.f);
-      } else {
+      } else if (i < track_end) {
         stepButtons[i].setAlpha(0.7f);
+      } else {
+        stepButtons[i].setAlpha(0.3f);  // past the end of the track
       }
     }
   }
@@ -492,6 +582,9 @@ public:
   void resized() override final {
     // layout
     trackCollapseButton.setBounds(0, 0, STEP_BUTTON_WIDTH, STEP_BUTTON_HEIGHT);
+    pageControls.setBounds(
+        (STEP_SEQ_PAGE_LENGTH + 1) * (STEP_BUTTON_WIDTH + STEP_BUTTON_SPACING),
+        0, TrackPageControls::WIDTH, STEP_BUTTON_HEIGHT);
     noteOneLabel.setBounds(0, STEP_BUTTON_HEIGHT, STEP_BUTTON_WIDTH,
                            KNOB_HEIGHT);
     noteTwoLabel.setBounds(0, STEP_BUTTON_HEIGHT + KNOB_HEIGHT,
@@ -509,7 +602,7 @@ public:
     probabilityLabel.setBounds(0, STEP_BUTTON_HEIGHT + KNOB_HEIGHT * 7,
                                STEP_BUTTON_WIDTH, KNOB_HEIGHT);
 
-    for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    for (int i = 0; i < STEP_SEQ_PAGE_LENGTH; ++i) {
       int x = (i + 1) * (STEP_BUTTON_WIDTH + STEP_BUTTON_SPACING);
       stepButtons[i].setBounds(x, 0, STEP_BUTTON_WIDTH, STEP_BUTTON_HEIGHT);
       noteOneKnobs[i].setBounds(x, STEP_BUTTON_HEIGHT, STEP_BUTTON_WIDTH,
@@ -541,18 +634,23 @@ private:
   Sequencer::Track& trackRef;
   int trackIndex_;
   bool collapsed_;
+  int shownPage_ = 0;
+
+  TrackPageControls pageControls;
 
   void setCollapsed(bool collapsed) {
     collapsed_ = collapsed;
     if (collapsed) {
-      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_DEFAULT_LENGTH + 1) +
-                  STEP_BUTTON_SPACING * STEP_SEQ_DEFAULT_LENGTH,
+      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  STEP_BUTTON_SPACING * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  TrackPageControls::WIDTH,
               STEP_BUTTON_HEIGHT);
       trackCollapseButton.setButtonText("Track " +
                                         juce::String(trackIndex_ + 1) + " ▶");
     } else {
-      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_DEFAULT_LENGTH + 1) +
-                  STEP_BUTTON_SPACING * STEP_SEQ_DEFAULT_LENGTH,
+      setSize(STEP_BUTTON_WIDTH * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  STEP_BUTTON_SPACING * (STEP_SEQ_PAGE_LENGTH + 1) +
+                  TrackPageControls::WIDTH,
               STEP_BUTTON_HEIGHT + KNOB_HEIGHT * 8);
       trackCollapseButton.setButtonText("Track " +
                                         juce::String(trackIndex_ + 1) + " ▼");
@@ -569,29 +667,29 @@ private:
   juce::Label lengthLabel;
   juce::Label probabilityLabel;
 
-  juce::TextButton stepButtons[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider noteOneKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider noteTwoKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider noteThreeKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider noteFourKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider velocityKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider offsetKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider lengthKnobs[STEP_SEQ_DEFAULT_LENGTH];
-  juce::Slider probabilityKnobs[STEP_SEQ_DEFAULT_LENGTH];
+  juce::TextButton stepButtons[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider noteOneKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider noteTwoKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider noteThreeKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider noteFourKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider velocityKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider offsetKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider lengthKnobs[STEP_SEQ_PAGE_LENGTH];
+  juce::Slider probabilityKnobs[STEP_SEQ_PAGE_LENGTH];
 
   using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
   using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
 
   // Parameter attachments
-  std::unique_ptr<ButtonAttachment> enableAttachments[STEP_SEQ_DEFAULT_LENGTH];
-  std::unique_ptr<SliderAttachment> noteOneAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      noteTwoAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      noteThreeAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      noteFourAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      velocityAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      offsetAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      lengthAttachments[STEP_SEQ_DEFAULT_LENGTH],
-      probabilityAttachments[STEP_SEQ_DEFAULT_LENGTH];
+  std::unique_ptr<ButtonAttachment> enableAttachments[STEP_SEQ_PAGE_LENGTH];
+  std::unique_ptr<SliderAttachment> noteOneAttachments[STEP_SEQ_PAGE_LENGTH],
+      noteTwoAttachments[STEP_SEQ_PAGE_LENGTH],
+      noteThreeAttachments[STEP_SEQ_PAGE_LENGTH],
+      noteFourAttachments[STEP_SEQ_PAGE_LENGTH],
+      velocityAttachments[STEP_SEQ_PAGE_LENGTH],
+      offsetAttachments[STEP_SEQ_PAGE_LENGTH],
+      lengthAttachments[STEP_SEQ_PAGE_LENGTH],
+      probabilityAttachments[STEP_SEQ_PAGE_LENGTH];
 };
 
 }  // namespace audio_plugin
\ No newline at end of file
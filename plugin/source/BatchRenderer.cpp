@@ -0,0 +1,125 @@
+#include "E3Seq/BatchRenderer.h"
+#include <juce_audio_processors/juce_audio_processors.h>  // getXmlFromBinary
+
+namespace Sequencer {
+
+namespace {
+
+struct JobResult {
+  int numFilesWritten = 0;
+  juce::int64 numEvents = 0;
+  juce::String error;  // empty on success
+};
+
+// runs on a worker thread
+JobResult renderPreset(const juce::File& presetFile,
+                       const juce::File& outputFolder,
+                       const BatchRenderer::Options& options) {
+  JobResult result;
+
+  auto xml = BatchRenderer::readPreset(presetFile);
+  if (xml == nullptr) {
+    result.error = "could not read preset";
+    return result;
+  }
+
+  for (int i = 0; i < options.seedsPerPreset; ++i) {
+    // a fresh renderer per seed so that alternate counters start from zero
+    OfflineRenderer renderer(options.bpm);
+    if (!renderer.loadPreset(*xml)) {
+      result.error = "not an E3Seq preset";
+      return result;
+    }
+
+    auto seed = options.baseSeed + i;
+    renderer.setSeed(seed);
+    auto sequence = renderer.renderLoops(options.numLoops);
+
+    auto output_file = outputFolder.getChildFile(
+        presetFile.getFileNameWithoutExtension() + "_seed" +
+        juce::String(seed) + ".mid");
+    if (!renderer.writeMidiFile(sequence, output_file)) {
+      result.error = "could not write " + output_file.getFileName();
+      return result;
+    }
+
+    result.numFilesWritten += 1;
+    result.numEvents += sequence.getNumEvents();
+  }
+
+  return result;
+}
+
+}  // namespace
+
+std::unique_ptr<juce::XmlElement> BatchRenderer::readPreset(
+    const juce::File& file) {
+  if (file.hasFileExtension("xml"))
+    return juce::XmlDocument::parse(file);
+
+  juce::MemoryBlock data;
+  if (!file.loadFileAsData(data))
+    return nullptr;
+
+  if (auto xml = juce::AudioProcessor::getXmlFromBinary(
+          data.getData(), static_cast<int>(data.getSize()))) {
+    return xml;
+  }
+
+  // could still be a XML preset with an unusual extension
+  return juce::XmlDocument::parse(data.toString());
+}
+
+BatchRenderer::Report BatchRenderer::run(const juce::File& presetFolder,
+                                         const juce::File& outputFolder,
+                                         const Options& options) {
+  auto preset_files = presetFolder.findChildFiles(
+      juce::File::findFiles | juce::File::ignoreHiddenFiles, false);
+  preset_files.sort();
+
+  Report report;
+  report.numPresets = preset_files.size();
+  if (preset_files.isEmpty() || !outputFolder.createDirectory()) {
+    if (!preset_files.isEmpty())
+      report.failures.add(outputFolder.getFullPathName() +
+                          ": could not create output folder");
+    return report;
+  }
+
+  // one slot per preset, written by exactly one job
+  std::vector<JobResult> results(static_cast<size_t>(preset_files.size()));
+  std::atomic<int> remaining_jobs{preset_files.size()};
+  juce::WaitableEvent all_jobs_done;
+
+  int num_threads = options.numThreads > 0 ? options.numThreads
+                                           : juce::SystemStats::getNumCpus();
+  juce::ThreadPool pool(num_threads);
+
+  auto start_time = juce::Time::getMillisecondCounterHiRes();
+
+  for (int i = 0; i < preset_files.size(); ++i) {
+    pool.addJob([&, i] {
+      results[static_cast<size_t>(i)] =
+          renderPreset(preset_files.getReference(i), outputFolder, options);
+      if (--remaining_jobs == 0)
+        all_jobs_done.signal();
+    });
+  }
+
+  all_jobs_done.wait();
+  report.elapsedSeconds =
+      (juce::Time::getMillisecondCounterHiRes() - start_time) * 0.001;
+
+  for (int i = 0; i < preset_files.size(); ++i) {
+    const auto& result = results[static_cast<size_t>(i)];
+    report.numFilesWritten += result.numFilesWritten;
+    report.numEvents += result.numEvents;
+    if (result.error.isNotEmpty())
+      report.failures.add(preset_files.getReference(i).getFileName() + ": " +
+                          result.error);
+  }
+
+  return report;
+}
+
+}  // namespace Sequencer
@@ -8,16 +8,20 @@
 
 namespace Sequencer {
 
-E3Sequencer::E3Sequencer(juce::MidiMessageCollector& midiCollector, double bpm)
-    : monoTracks_{{1, keyboardMonitor_}, {2, keyboardMonitor_},
-                  {3, keyboardMonitor_}, {4, keyboardMonitor_},
-                  {5, keyboardMonitor_}, {6, keyboardMonitor_},
-                  {7, keyboardMonitor_}, {8, keyboardMonitor_}},
-      polyTracks_{{9, keyboardMonitor_},
-                  {10, keyboardMonitor_},
-                  {11, keyboardMonitor_},
-                  {12, keyboardMonitor_}},
+template <typename Config>
+BasicE3Sequencer<Config>::BasicE3Sequencer(
+    juce::MidiMessageCollector& midiCollector,
+    double bpm)
+    : monoTracks_(makeTracks<MonoTrack, 1>(
+          keyboardMonitor_,
+          std::make_index_sequence<numMonoTracks>{})),
+      polyTracks_(makeTracks<PolyTrack, numMonoTracks + 1>(
+          keyboardMonitor_,
+          std::make_index_sequence<numPolyTracks>{})),
       bpm_(bpm),
+      tempo_(Config::ticksPerStep, bpm, TEMPO_SEGMENTS),
+      requestedTempo_(TempoRequest{static_cast<float>(bpm), 0.f}),
+      appliedBpm_(static_cast<float>(bpm)),
       running_(false),
       armed_(false),
       quantizeRec_(false),
@@ -25,62 +29,299 @@ E3Sequencer::E3Sequencer(juce::MidiMessageCollector& midiCollector, double bpm)
       startTime_(0.0),
       midiCollector_(midiCollector) {
   // MARK: track config
-  for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
+  for (int channel = 1; channel <= numTracks; ++channel) {
     Track& track = getTrackByChannel(channel);
     track.sendMidiMessage = [this](juce::MidiMessage msg) {
-      // time translation
-      int tick = (int)msg.getTimeStamp();
-      double real_time_stamp = startTime_ + getOneTickTime() * tick;
-      // this time translation code is smelling....need some further thinking
-      this->midiCollector_.addMessageToQueue(
-          msg.withTimeStamp(real_time_stamp));
+      sendToOutbox(msg);
     };
   }
+  sendClockMessage = [this](juce::MidiMessage msg) { sendToCollector(msg); };
+  setLookahead(LOOKAHEAD_STEPS_DEFAULT);
+  publishPosition();
+  lastPosition_ = getPlayPosition();
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::sendToCollector(const juce::MidiMessage& msg) {
+  // time translation
+  // (tracks stamp their messages with the ticks since start)
+  double real_time_stamp = getTickTime(msg.getTimeStamp());
+  midiCollector_.addMessageToQueue(msg.withTimeStamp(real_time_stamp));
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::sendToOutbox(const juce::MidiMessage& msg) {
+  // a full queue sends straight away, early rather than never
+  auto stamped = msg.withTimeStamp(getTickTime(msg.getTimeStamp()));
+  if (!outbox_.push(stamped)) {
+    midiCollector_.addMessageToQueue(stamped);
+  }
 }
 
 // note: for time precision, deltaTime should be much smaller than OneTickTime
-void E3Sequencer::process(double deltaTime) {
+template <typename Config>
+void BasicE3Sequencer<Config>::process(double deltaTime) {
+  mergeRecordedNotes();
+  // moved by start(), stop() or resume() since the last call
+  if (positionMoved_.exchange(false)) {
+    publishPosition();
+  }
+
+  if (const auto* clock = followClock_.load()) {
+    followSharedClock(*clock, deltaTime);
+    return;
+  }
+
+  if (syncToHost_ && !syncToMidiClock_) {
+    followHost(deltaTime);
+    return;
+  }
+
   if (!running_)
     return;
 
+  if (syncToMidiClock_) {
+    followMidiClock(deltaTime);
+    return;
+  }
+
   timeSinceStart_ += deltaTime;
   double one_tick_time = getOneTickTime();
 
   if (timeSinceStart_ >= one_tick_time) {
-    for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
-      int step_index = getTrackByChannel(channel).getCurrentStepIndex();
-
-      getTrackByChannel(channel).tick();
-
-      // in case there is a note stealing
-      if (channel <= STEP_SEQ_NUM_MONO_TRACKS) {
-        notifyProcessorMonoStepUpdate(
-            channel - 1, step_index,
-            getMonoTrack(channel - 1).getStepAtIndex(step_index));
-      } else {
-        notifyProcessorPolyStepUpdate(
-            channel - 1 - STEP_SEQ_NUM_MONO_TRACKS, step_index,
-            getPolyTrack(channel - 1 - STEP_SEQ_NUM_MONO_TRACKS)
-                .getStepAtIndex(step_index));
-      }
-    }
+    tick();
     timeSinceStart_ -= one_tick_time;
   }
 
   return;
 }
 
-void E3Sequencer::start(double startTime) {
+template <typename Config>
+void BasicE3Sequencer<Config>::followMidiClock(double deltaTime) {
+  // ticks still held back by the previous pulse are played at once (the
+  // master got faster), then the new pulse releases its own
+  int pulses = pendingClocks_.exchange(0);
+  for (int i = 0; i < pulses; ++i) {
+    for (; ticksToPlay_ > 0; --ticksToPlay_) {
+      tick();
+    }
+    ticksToPlay_ = ticksPerClock;
+    timeSincePulse_ = 0.0;
+    ++clocksSinceStart_;
+  }
+
+  double period = clock_.getPeriod();
+  if (period > 0.0) {
+    setBpm(clock_.getBpm());
+    if (pulses > 0) {
+      // keep the time stamps of the tracks in line with the clock
+      startTime_ = clock_.getPulseTime() -
+                   tempo_.getTime((clocksSinceStart_ - 1) * ticksPerClock);
+      publishPosition();
+    }
+  }
+
+  timeSincePulse_ += deltaTime;
+  double one_tick_time = getOneTickTime();
+  while (ticksToPlay_ > 0 &&
+         timeSincePulse_ >= (ticksPerClock - ticksToPlay_) * one_tick_time) {
+    tick();
+    --ticksToPlay_;
+  }
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::setHostPosition(double ppqPosition,
+                                               double time,
+                                               bool playing) {
+  host_.store({ppqPosition, time, playing});
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::followHost(double deltaTime) {
+  HostPosition host;
+  unsigned version;
+  // (a position being written right now is picked up next time)
+  if (host_.load(host, version) && version != hostVersionRead_) {
+    hostVersionRead_ = version;
+    lineUp(host.ppq * Config::ticksPerStep * 4, host.time, host.playing);
+  }
+  followPosition(deltaTime);
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::followSharedClock(const SharedClock& clock,
+                                                 double deltaTime) {
+  SharedClock::Position position;
+  if (clock.read(position, sharedVersionRead_)) {
+    // (the tempo is the leader's, there is no ramp to follow)
+    if (position.playing) {
+      setBpm(position.bpm);
+    }
+    lineUp(position.tick, position.time, position.playing);
+  }
+  followPosition(deltaTime);
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::lineUp(double tick, double time, bool playing) {
+  if (!playing) {
+    if (running_) {
+      stop();
+    }
+    return;
+  }
+
+  // the tempo of the position starts here
+  applyTempo();
+  hostTick_ = tick;
+  timeSinceHost_ = 0.0;
+  // line the time stamps up with the position, the error is where the
+  // previous positions put this one
+  if (running_) {
+    hostPhaseError_.store(getTickTime(hostTick_) - time);
+  }
+  startTime_ = time - tempo_.getTime(hostTick_);
+
+  if (!running_) {
+    auto start_tick = static_cast<juce::int64>(std::floor(hostTick_));
+    locate(start_tick);
+    running_ = true;
+    sendClock(start_tick == 0 ? juce::MidiMessage::midiStart()
+                              : juce::MidiMessage::midiContinue());
+    hostPhaseError_.store(0.0);
+  }
+  publishPosition();
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::followPosition(double deltaTime) {
+  if (!running_)
+    return;
+
+  // a tick is played once the host is past it, like in process()
+  timeSinceHost_ += deltaTime;
+  double position = hostTick_ + timeSinceHost_ / getOneTickTime();
+  double behind = position - static_cast<double>(clockTick_);
+  constexpr double tolerance = Config::ticksPerStep / 2;
+  if (behind < -tolerance || behind > 1.0 + tolerance) {
+    // the host jumped (loop, relocation), not worth catching up with
+    locate(static_cast<juce::int64>(std::floor(position)));
+  }
+  while (static_cast<double>(clockTick_ + 1) <= position) {
+    tick();
+  }
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::applyTempo() {
+  TempoRequest request = requestedTempo_.load();
+  double requested = request.bpm;
+  if (requested != appliedBpm_) {
+    appliedBpm_ = requested;
+    auto ramp_ticks = static_cast<juce::int64>(
+        std::lround(request.rampSteps * Config::ticksPerStep));
+    tempo_.rampTempo(clockTick_, requested, ramp_ticks);
+  }
+  tempo_.forget(clockTick_ - TEMPO_HISTORY_TICKS);
+
+  // (the delays are kept in ticks)
+  double bpm = tempo_.getBpm(static_cast<double>(clockTick_));
+  bool delays_changed = delaysChanged_.exchange(false);
+  if (bpm != bpm_ || delays_changed) {
+    bpm_ = bpm;
+    updateTrackDelays();
+  }
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::tick() {
+  applyTempo();
+
+  // the clock goes out on the tick it belongs to, before that tick's notes
+  if (clockTick_ % ticksPerClock == 0) {
+    sendClock(juce::MidiMessage::midiClock());
+  }
+
+  for (int channel = 1; channel <= numTracks; ++channel) {
+    getTrackByChannel(channel).tick();
+  }
+
+  // in case there is a note stealing (only poly tracks steal, when a step is
+  // rendered, ahead of the play position)
+  for (int i = 0; i < numPolyTracks; ++i) {
+    int step_index = getPolyTrack(i).takeStolenStep();
+    if (step_index >= 0 && notifyProcessorPolyStepUpdate) {
+      notifyProcessorPolyStepUpdate(i, step_index,
+                                    getPolyTrack(i).getStepAtIndex(step_index));
+    }
+  }
+  ++clockTick_;
+  publishPosition();
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::start(double startTime) {
   running_ = true;
-  timeSinceStart_ = 0.0;
   startTime_ = startTime;
-  for (int channel = 1; channel < STEP_SEQ_NUM_TRACKS; ++channel) {
+  returnToStart();
+  positionMoved_.store(true);
+  sendClock(juce::MidiMessage::midiStart());
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::rewind() {
+  returnToStart();
+  // a start message already means the first step
+  if (!running_) {
+    sendClock(juce::MidiMessage::songPositionPointer(0));
+  }
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::locate(juce::int64 tick) {
+  if (running_) {
+    sendClock(juce::MidiMessage::midiStop());
+  }
+  timeSinceStart_ = 0.0;
+  clockTick_ = tick;
+  // what was sent ahead on the way there does not play
+  outbox_.drop();
+  // tempo changes ahead were made on the way there, not for the way on
+  // (the ticks up to here keep their time)
+  tempo_.setTempo(tick, bpm_);
+  for (int channel = 1; channel <= numTracks; ++channel) {
+    getTrackByChannel(channel).locate(tick);
+  }
+  publishPosition();
+
+  // the song position pointer counts steps (16th notes), in 14 bits
+  auto steps = std::min<juce::int64>(tick / Config::ticksPerStep, 16383);
+  sendClock(juce::MidiMessage::songPositionPointer(static_cast<int>(steps)));
+  if (running_) {
+    sendClock(juce::MidiMessage::midiContinue());
+  }
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::returnToStart() {
+  timeSinceStart_ = 0.0;
+  pendingClocks_.store(0);
+  clocksSinceStart_ = 0;
+  ticksToPlay_ = 0;
+  timeSincePulse_ = 0.0;
+  clockTick_ = 0;
+  tempo_.reset(bpm_);
+  for (int channel = 1; channel <= numTracks; ++channel) {
     getTrackByChannel(channel).returnToStart();
   }
 }
 
-Note E3Sequencer::calculateNoteFromNoteOnAndOff(juce::MidiMessage noteOn,
-                                                juce::MidiMessage noteOff) {
+template <typename Config>
+typename BasicE3Sequencer<Config>::Note
+BasicE3Sequencer<Config>::calculateNoteFromNoteOnAndOff(
+    juce::MidiMessage noteOn,
+    juce::MidiMessage noteOff) {
 #ifdef JUCE_DEBUG
   jassert(noteOn.getNoteNumber() == noteOff.getNoteNumber());
   jassert(noteOn.getChannel() == noteOff.getChannel());
@@ -88,42 +329,84 @@ Note E3Sequencer::calculateNoteFromNoteOnAndOff(juce::MidiMessage noteOn,
   int note_number = noteOn.getNoteNumber();
   int velocity = noteOn.getVelocity();
 
+  // in steps of the track since start (the messages are stamped in ticks of
+  // the sequencer, the track may run at another speed)
+  const Track& track = getTrackByChannel(noteOn.getChannel());
+  double on = track.getTrackTick(noteOn.getTimeStamp()) / Config::ticksPerStep;
+  double off =
+      track.getTrackTick(noteOff.getTimeStamp()) / Config::ticksPerStep;
+
   double offset = 0.0;
   if (!quantizeRec_) {
-    offset = (noteOn.getTimeStamp() - startTime_) / getOneStepTime();
-    offset -= std::round(offset);  // wrap in [-0.5, 0.5)
+    offset = on - std::round(on);  // wrap in [-0.5, 0.5)
   }
 
-  auto length =
-      (noteOff.getTimeStamp() - noteOn.getTimeStamp()) / getOneStepTime();
+  auto length = off - on;
   length = std::min(
-      length, static_cast<double>(STEP_SEQ_MAX_LENGTH));  // clip to loop length
+      length, static_cast<double>(Config::maxLength));  // clip to loop length
 
   return {.number = note_number,
           .velocity = velocity,
-          .offset = static_cast<float>(offset),
-          .length = static_cast<float>(length)};
+          .offset_ticks = Config::offsetToTicks(static_cast<float>(offset)),
+          .length_ticks = Config::lengthToTicks(static_cast<float>(length))};
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::handleNoteOn(juce::MidiMessage noteOn) {
+  if (noteOn.getChannel() > numTracks)
+    return;
+
+  recorded_.push({noteOn.getTimeStamp(),
+                  static_cast<juce::uint8>(noteOn.getChannel()),
+                  static_cast<juce::uint8>(noteOn.getNoteNumber()),
+                  noteOn.getVelocity(), true});
 }
 
-void E3Sequencer::handleNoteOn(juce::MidiMessage noteOn) {
-  if (noteOn.getChannel() > STEP_SEQ_NUM_TRACKS)
+template <typename Config>
+void BasicE3Sequencer<Config>::handleNoteOff(juce::MidiMessage noteOff) {
+  if (noteOff.getChannel() > numTracks)
     return;
 
+  recorded_.push({noteOff.getTimeStamp(),
+                  static_cast<juce::uint8>(noteOff.getChannel()),
+                  static_cast<juce::uint8>(noteOff.getNoteNumber()),
+                  noteOff.getVelocity(), false});
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::mergeRecordedNotes() {
+  RecordedNote note;
+  while (recorded_.pop(note)) {
+    auto message =
+        note.isNoteOn
+            ? juce::MidiMessage::noteOn(note.channel, note.number,
+                                        note.velocity)
+            : juce::MidiMessage::noteOff(note.channel, note.number,
+                                         note.velocity);
+    message.setTimeStamp(note.tick);
+    if (note.isNoteOn) {
+      recordNoteOn(message);
+    } else {
+      recordNoteOff(message);
+    }
+  }
+}
+
+template <typename Config>
+void BasicE3Sequencer<Config>::recordNoteOn(juce::MidiMessage noteOn) {
   int channel = noteOn.getChannel();
-  int step_index = getTrackByChannel(channel).getCurrentStepIndex();
+  int step_index = getTrackByChannel(channel).getStepIndexAt(
+      static_cast<juce::int64>(std::floor(noteOn.getTimeStamp())));
 
   keyboardMonitor_.processNoteOn(noteOn, step_index);
 }
 
 // TODO: this function is getting too big, consider refactoring
-void E3Sequencer::handleNoteOff(juce::MidiMessage noteOff) {
+template <typename Config>
+void BasicE3Sequencer<Config>::recordNoteOff(juce::MidiMessage noteOff) {
   int note_number = noteOff.getNoteNumber();
   int channel = noteOff.getChannel();
 
-  // ignore Midi channel > 12
-  if (channel > STEP_SEQ_NUM_TRACKS)
-    return;
-
   juce::MidiMessage note_on;
   int step_index;
 
@@ -134,7 +417,7 @@ void E3Sequencer::handleNoteOff(juce::MidiMessage noteOff) {
       if (this->isArmed() && this->isRunning()) {
         auto new_note = calculateNoteFromNoteOnAndOff(note_on, noteOff);
 
-        if (channel <= STEP_SEQ_NUM_MONO_TRACKS) {
+        if (channel <= numMonoTracks) {
           // for mono tracks
           MonoStep step{.enabled = true, .note = new_note};
           // same as below
@@ -142,21 +425,14 @@ void E3Sequencer::handleNoteOff(juce::MidiMessage noteOff) {
           notifyProcessorMonoStepUpdate(channel - 1, step_index, step);
         } else {
           // for poly tracks
-          PolyStep step = getPolyTrack(channel - 1 - STEP_SEQ_NUM_MONO_TRACKS)
+          PolyStep step = getPolyTrack(channel - 1 - numMonoTracks)
                               .getStepAtIndex(step_index);
           step.addNote(new_note);
-          // this call is essential to avoid syncronization issues between audio
-          // and hires timer
-          getPolyTrack(channel - 1 - STEP_SEQ_NUM_MONO_TRACKS)
+          getPolyTrack(channel - 1 - numMonoTracks)
               .setStepAtIndex(step_index, step);
 
-          // important note:
-          // it might make sense to set up some mechanism to pass information
-          // from audio thread (this function) to hi-res timer (sequencer logic
-          // thread)
-
           // notify AudioProcessor about parameter change
-          notifyProcessorPolyStepUpdate(channel - 1 - STEP_SEQ_NUM_MONO_TRACKS,
+          notifyProcessorPolyStepUpdate(channel - 1 - numMonoTracks,
                                         step_index, step);
         }
       }
@@ -168,4 +444,8 @@ void E3Sequencer::handleNoteOff(juce::MidiMessage noteOff) {
 #endif
   }
 }
+template class BasicE3Sequencer<DefaultConfig>;
+template class BasicE3Sequencer<EmbeddedConfig>;
+template class BasicE3Sequencer<DesktopConfig>;
+
 }  // namespace Sequencer
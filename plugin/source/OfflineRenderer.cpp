@@ -0,0 +1,217 @@
+#include "E3Seq/OfflineRenderer.h"
+#include "E3Seq/PatternState.h"
+#include <map>
+
+namespace Sequencer {
+
+OfflineRenderer::OfflineRenderer(double bpm)
+    : sequencer_(collector_, bpm), currentTick_(0) {
+  collector_.reset(44100.0);  // only to keep MidiMessageCollector happy
+
+  // collect MIDI messages with their absolute tick as timestamp
+  // (they may be sent a little ahead, stamped with the tick they play at,
+  // see Track::setLookahead())
+  for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
+    sequencer_.getTrackByChannel(channel).sendMidiMessage =
+        [this](juce::MidiMessage msg) {
+          rendered_.addEvent(msg.withTimeStamp(std::ceil(msg.getTimeStamp())));
+        };
+  }
+}
+
+// MARK: preset loading
+// note: parameter IDs and default values must match
+// AudioPluginAudioProcessor::createParameterLayout()
+bool OfflineRenderer::loadPreset(const juce::XmlElement& xml) {
+  using Config = DefaultConfig;
+
+  if (!xml.hasTagName("E3Seq"))
+    return false;
+
+  std::map<juce::String, float> values;
+  for (auto* param : xml.getChildWithTagNameIterator("PARAM")) {
+    values[param->getStringAttribute("id")] =
+        static_cast<float>(param->getDoubleAttribute("value"));
+  }
+
+  auto get = [&values](const juce::String& id, float default_value) {
+    auto it = values.find(id);
+    return it == values.end() ? default_value : it->second;
+  };
+
+  for (int track = 0; track < STEP_SEQ_NUM_TRACKS; ++track) {
+    juce::String prefix = "T" + juce::String(track) + "_";
+    auto& t = sequencer_.getTrackByChannel(track + 1);
+    t.setSeed(static_cast<uint32_t>(get(prefix + "SEED", 0.f)));
+    t.setSeedLocked(get(prefix + "SEED_LOCK", 0.f) > 0.5f);
+    t.setLength(static_cast<int>(
+        get(prefix + "TRACK_LENGTH", STEP_SEQ_DEFAULT_LENGTH)));
+    sequencer_.setTrackDelay(track + 1, get(prefix + "DELAY", 0.f));
+    t.setSpeed(TRACK_SPEEDS[static_cast<int>(
+        get(prefix + "SPEED", TRACK_SPEED_DEFAULT_INDEX))]);
+    t.setSyncMode(get(prefix + "RESYNC", 0.f) > 0.5f
+                      ? Track::SyncMode::MasterLoop
+                      : Track::SyncMode::Free);
+    t.setPlayMode(
+        static_cast<Track::PlayMode>(get(prefix + "PLAY_MODE", 0.f)));
+    sequencer_.setTrackSwing(track + 1, get(prefix + "SWING", 50.f) * 0.01f);
+  }
+  sequencer_.setSwing(get("SWING", 50.f) * 0.01f);
+  sequencer_.setMasterLength(
+      static_cast<int>(get("MASTER_LENGTH", STEP_SEQ_DEFAULT_LENGTH)));
+
+  if (auto* pattern = xml.getChildByName(PatternState::TAG)) {
+    return PatternState::read(*pattern, sequencer_);
+  }
+
+  // presets saved before paging only have the first page, as parameters
+  for (int track = 0; track < STEP_SEQ_NUM_MONO_TRACKS; ++track) {
+    for (int step = 0; step < STEP_SEQ_PAGE_LENGTH; ++step) {
+      juce::String prefix =
+          "T" + juce::String(track) + "_S" + juce::String(step) + "_";
+      MonoStep mono_step{
+          .enabled = get(prefix + "ENABLED", 0.f) > 0.5f,
+          .note = {.number =
+                       static_cast<int>(get(prefix + "NOTE", DEFAULT_NOTE)),
+                   .velocity = static_cast<int>(
+                       get(prefix + "VELOCITY", DEFAULT_VELOCITY)),
+                   .offset_ticks = Config::offsetToTicks(
+                       get(prefix + "OFFSET", 0.f)),
+                   .length_ticks = Config::lengthToTicks(
+                       get(prefix + "LENGTH", DEFAULT_LENGTH))},
+          .retrigger_ticks =
+              Config::stepsToTicks(get(prefix + "RETRIGGER", 0.f)),
+          .probability = get(prefix + "PROBABILITY", 1.f),
+          .alternate = static_cast<int>(get(prefix + "ALTERNATE", 1.f)),
+      };
+      sequencer_.getMonoTrack(track).setStepAtIndex(step, mono_step);
+    }
+  }
+
+  for (int track = 0; track < STEP_SEQ_NUM_POLY_TRACKS; ++track) {
+    for (int step = 0; step < STEP_SEQ_PAGE_LENGTH; ++step) {
+      juce::String prefix = "T" +
+                            juce::String(track + STEP_SEQ_NUM_MONO_TRACKS) +
+                            "_S" + juce::String(step) + "_";
+      PolyStep poly_step;
+      poly_step.enabled = get(prefix + "ENABLED", 0.f) > 0.5f;
+      poly_step.probability = get(prefix + "PROBABILITY", 1.f);
+
+      for (int note = 0; note < POLYPHONY; ++note) {
+        juce::String note_prefix = prefix + "N" + juce::String(note) + "_";
+        auto& n = poly_step.notes[note];
+        n.number = static_cast<int>(get(
+            note_prefix + "NOTE", note == 0 ? DEFAULT_NOTE : DISABLED_NOTE));
+        n.velocity =
+            static_cast<int>(get(note_prefix + "VELOCITY", DEFAULT_VELOCITY));
+        n.offset_ticks =
+            Config::offsetToTicks(get(note_prefix + "OFFSET", 0.f));
+        n.length_ticks =
+            Config::lengthToTicks(get(note_prefix + "LENGTH", DEFAULT_LENGTH));
+      }
+      sequencer_.getPolyTrack(track).setStepAtIndex(step, poly_step);
+    }
+  }
+
+  return true;
+}
+
+void OfflineRenderer::setSeed(juce::int64 seed) {
+  for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
+    sequencer_.getTrackByChannel(channel).setSeed(static_cast<uint32_t>(seed));
+  }
+}
+
+// MARK: rendering
+
+// of the longest track, at its speed
+int OfflineRenderer::getLoopLengthInTicks() {
+  int longest = 0;
+  for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
+    const auto& track = sequencer_.getTrackByChannel(channel);
+    auto speed = track.getSpeed();
+    longest = std::max(longest, (track.getLength() * TICKS_PER_STEP *
+                                     speed.denominator +
+                                 speed.numerator - 1) /
+                                    speed.numerator);
+  }
+  return longest;
+}
+
+juce::MidiMessageSequence OfflineRenderer::renderLoops(int numLoops) {
+  return renderTicks(numLoops * getLoopLengthInTicks());
+}
+
+juce::MidiMessageSequence OfflineRenderer::renderDuration(double seconds) {
+  return renderTicks(
+      static_cast<int>(std::ceil(seconds / sequencer_.getOneTickTime())));
+}
+
+juce::MidiMessageSequence OfflineRenderer::renderTicks(int numTicks) {
+  rendered_.clear();
+  sequencer_.start(0.0);
+
+  for (currentTick_ = 0; currentTick_ < numTicks; ++currentTick_) {
+    sequencer_.tick();
+  }
+  // what was sent ahead of the end is not part of the render
+  for (int i = rendered_.getNumEvents(); --i >= 0;) {
+    if (rendered_.getEventTime(i) >= numTicks) {
+      rendered_.deleteEvent(i, false);
+    }
+  }
+
+  // close notes that are still hanging at the end of the render
+  int hanging[STEP_SEQ_NUM_TRACKS][128] = {};
+  for (int i = 0; i < rendered_.getNumEvents(); ++i) {
+    const auto& message = rendered_.getEventPointer(i)->message;
+    int channel = message.getChannel();
+    if (channel < 1 || channel > STEP_SEQ_NUM_TRACKS)
+      continue;
+    if (message.isNoteOn()) {
+      hanging[channel - 1][message.getNoteNumber()] += 1;
+    } else if (message.isNoteOff()) {
+      hanging[channel - 1][message.getNoteNumber()] -= 1;
+    }
+  }
+  for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
+    for (int note = 0; note < 128; ++note) {
+      for (int i = 0; i < hanging[channel - 1][note]; ++i) {
+        rendered_.addEvent(juce::MidiMessage::noteOff(channel, note),
+                           numTicks);
+      }
+    }
+  }
+
+  rendered_.updateMatchedPairs();
+  return rendered_;
+}
+
+// MARK: MIDI file
+
+bool OfflineRenderer::writeMidiFile(const juce::MidiMessageSequence& sequence,
+                                    const juce::File& file) const {
+  juce::MidiFile midi_file;
+  midi_file.setTicksPerQuarterNote(MIDI_FILE_PPQ);
+
+  juce::MidiMessageSequence tempo_track;
+  tempo_track.addEvent(juce::MidiMessage::tempoMetaEvent(
+      static_cast<int>(60000000.0 / sequencer_.getBpm())));
+  tempo_track.addEvent(juce::MidiMessage::timeSignatureMetaEvent(4, 4));
+  midi_file.addTrack(tempo_track);
+
+  for (int channel = 1; channel <= STEP_SEQ_NUM_TRACKS; ++channel) {
+    juce::MidiMessageSequence track;
+    sequence.extractMidiChannelMessages(channel, track, false);
+    midi_file.addTrack(track);
+  }
+
+  file.deleteFile();
+  juce::FileOutputStream stream(file);
+  if (!stream.openedOk())
+    return false;
+
+  return midi_file.writeTo(stream);
+}
+
+}  // namespace Sequencer
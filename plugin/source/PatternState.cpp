@@ -0,0 +1,126 @@
+#include "E3Seq/PatternState.h"
+
+namespace Sequencer {
+
+namespace {
+using Config = DefaultConfig;
+
+void writeNote(juce::XmlElement& element, const Note& note) {
+  element.setAttribute("number", note.number);
+  element.setAttribute("velocity", note.velocity);
+  element.setAttribute("offset", Config::ticksToSteps(note.offset_ticks));
+  element.setAttribute("length", Config::ticksToSteps(note.length_ticks));
+}
+
+Note readNote(const juce::XmlElement& element, Note note) {
+  note.number = element.getIntAttribute("number", note.number);
+  note.velocity = element.getIntAttribute("velocity", note.velocity);
+  note.offset_ticks = Config::offsetToTicks(static_cast<float>(
+      element.getDoubleAttribute("offset",
+                                 Config::ticksToSteps(note.offset_ticks))));
+  note.length_ticks = Config::lengthToTicks(static_cast<float>(
+      element.getDoubleAttribute("length",
+                                 Config::ticksToSteps(note.length_ticks))));
+  return note;
+}
+}  // namespace
+
+std::unique_ptr<juce::XmlElement> PatternState::write(E3Sequencer& sequencer) {
+  auto pattern = std::make_unique<juce::XmlElement>(TAG);
+
+  for (int track = 0; track < E3Sequencer::numMonoTracks; ++track) {
+    auto* track_element = pattern->createNewChildElement("TRACK");
+    track_element->setAttribute("index", track);
+
+    const MonoStep default_step;
+    for (int index = 0; index < Config::maxLength; ++index) {
+      auto step = sequencer.getMonoTrack(track).getStepAtIndex(index);
+      step.count = 0;  // playback state, not part of the pattern
+      if (step == default_step)
+        continue;
+
+      auto* step_element = track_element->createNewChildElement("STEP");
+      step_element->setAttribute("index", index);
+      step_element->setAttribute("enabled", step.enabled);
+      writeNote(*step_element, step.note);
+      step_element->setAttribute(
+          "retrigger", Config::ticksToSteps(step.retrigger_ticks));
+      step_element->setAttribute("probability", step.probability);
+      step_element->setAttribute("alternate", step.alternate);
+    }
+  }
+
+  for (int track = 0; track < E3Sequencer::numPolyTracks; ++track) {
+    auto* track_element = pattern->createNewChildElement("TRACK");
+    track_element->setAttribute("index", track + E3Sequencer::numMonoTracks);
+
+    const PolyStep default_step;
+    for (int index = 0; index < Config::maxLength; ++index) {
+      auto step = sequencer.getPolyTrack(track).getStepAtIndex(index);
+      if (step == default_step)
+        continue;
+
+      auto* step_element = track_element->createNewChildElement("STEP");
+      step_element->setAttribute("index", index);
+      step_element->setAttribute("enabled", step.enabled);
+      step_element->setAttribute("probability", step.probability);
+      for (int n = 0; n < PolyStep::polyphony; ++n) {
+        auto* note_element = step_element->createNewChildElement("NOTE");
+        note_element->setAttribute("index", n);
+        writeNote(*note_element, step.notes[n]);
+      }
+    }
+  }
+
+  return pattern;
+}
+
+bool PatternState::read(const juce::XmlElement& pattern,
+                        E3Sequencer& sequencer) {
+  if (!pattern.hasTagName(TAG))
+    return false;
+
+  sequencer.clearSteps();
+
+  for (auto* track_element : pattern.getChildWithTagNameIterator("TRACK")) {
+    int track = track_element->getIntAttribute("index", -1);
+    if (track < 0 || track >= E3Sequencer::numTracks)
+      continue;
+
+    for (auto* step_element :
+         track_element->getChildWithTagNameIterator("STEP")) {
+      int index = step_element->getIntAttribute("index", -1);
+      if (index < 0 || index >= Config::maxLength)
+        continue;
+
+      if (track < E3Sequencer::numMonoTracks) {
+        MonoStep step;
+        step.enabled = step_element->getBoolAttribute("enabled", false);
+        step.note = readNote(*step_element, step.note);
+        step.retrigger_ticks = Config::stepsToTicks(
+            static_cast<float>(step_element->getDoubleAttribute("retrigger")));
+        step.probability = static_cast<float>(
+            step_element->getDoubleAttribute("probability", 1.0));
+        step.alternate = step_element->getIntAttribute("alternate", 1);
+        sequencer.getMonoTrack(track).setStepAtIndex(index, step);
+      } else {
+        PolyStep step;
+        step.enabled = step_element->getBoolAttribute("enabled", false);
+        step.probability = static_cast<float>(
+            step_element->getDoubleAttribute("probability", 1.0));
+        for (auto* note_element :
+             step_element->getChildWithTagNameIterator("NOTE")) {
+          int n = note_element->getIntAttribute("index", -1);
+          if (n >= 0 && n < PolyStep::polyphony)
+            step.notes[n] = readNote(*note_element, step.notes[n]);
+        }
+        sequencer.getPolyTrack(track - E3Sequencer::numMonoTracks)
+            .setStepAtIndex(index, step);
+      }
+    }
+  }
+
+  return true;
+}
+
+}  // namespace Sequencer
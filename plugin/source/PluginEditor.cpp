@@ -64,9 +64,8 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(
     stopButton.addShortcut(juce::KeyPress('s'));
     stopButton.setTooltip("stop playback and move to start position (s)");
     stopButton.onClick = [this] {
-      processorRef.sequencer.start(juce::Time::getMillisecondCounterHiRes() *
-                                   0.001);
       processorRef.sequencer.stop();
+      processorRef.sequencer.rewind();
       playButton.setToggleState(false,
                                 juce::NotificationType::dontSendNotification);
     };
@@ -85,6 +84,29 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(
     };
     addAndMakeVisible(bpmSlider);
 
+    clockButton.setButtonText("Ext Clock");
+    clockButton.setClickingTogglesState(true);
+    clockButton.setTooltip("follow incoming MIDI clock, start and stop");
+    clockButton.setColour(juce::TextButton::ColourIds::buttonOnColourId,
+                          juce::Colours::orangered);
+    clockButton.onClick = [this] {
+      bool sync = clockButton.getToggleState();
+      processorRef.sequencer.setSyncToMidiClock(sync);
+      bpmSlider.setEnabled(!sync);
+    };
+    addAndMakeVisible(clockButton);
+
+    clockOutButton.setButtonText("Clock Out");
+    clockOutButton.setClickingTogglesState(true);
+    clockOutButton.setTooltip("send MIDI clock, start and stop");
+    clockOutButton.setColour(juce::TextButton::ColourIds::buttonOnColourId,
+                             juce::Colours::orangered);
+    clockOutButton.onClick = [this] {
+      processorRef.sequencer.setSendMidiClock(
+          clockOutButton.getToggleState());
+    };
+    addAndMakeVisible(clockOutButton);
+
     keyboardMidiChannelLabel.setText(
         "Keyboard trigger MIDI channel: ",
         juce::NotificationType::dontSendNotification);
@@ -162,7 +184,7 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(
   // editor's size to whatever you need it to be.
 
   // MARK: Initialization
-  setSize(1220, 700);
+  setSize(1480, 700);
   setResizable(true, true);
 }
 
@@ -211,6 +233,10 @@ void AudioPluginAudioProcessorEditor::resized() {
   utility_bar.removeFromLeft(40);
   bpmSlider.setBounds(utility_bar.removeFromLeft(200));
   utility_bar.removeFromLeft(10);
+  clockButton.setBounds(utility_bar.removeFromLeft(STEP_BUTTON_WIDTH * 2));
+  utility_bar.removeFromLeft(10);
+  clockOutButton.setBounds(utility_bar.removeFromLeft(STEP_BUTTON_WIDTH * 2));
+  utility_bar.removeFromLeft(10);
 
   helpButton.setBounds(utility_bar.removeFromRight(STEP_BUTTON_HEIGHT));
   utility_bar.removeFromRight(10);
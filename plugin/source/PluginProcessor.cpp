@@ -1,9 +1,22 @@
 #include "E3Seq/PluginProcessor.h"
 #include "E3Seq/PluginEditor.h"
+#include "E3Seq/PatternState.h"
 
 #define HIRES_TIMER_INTERVAL_MS 1
 #define TIMER_INTERVAL_MS 10
 
+// upper bound of the note length parameters (in steps), kept at the range it
+// had before patterns could be longer than 16 steps
+#define MAX_NOTE_LENGTH 16
+
+// range of the per-track latency compensation (in ms)
+#define MAX_TRACK_DELAY_MS 100.0f
+// range of the recording input latency compensation (in ms)
+#define MAX_INPUT_LATENCY_MS 50.0f
+// range of the swing parameters in % (see SequencerConfig::swingToTicks())
+#define SWING_MIN_PERCENT 50.0f
+#define SWING_MAX_PERCENT 75.0f
+
 namespace audio_plugin {
 AudioPluginAudioProcessor::AudioPluginAudioProcessor()
     : AudioProcessor(
@@ -29,8 +42,36 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
   }
 #endif
   // store parameter pointers which can be safely accessed in timer thread
+  for (int track = 0; track < STEP_SEQ_NUM_TRACKS; ++track) {
+    juce::String prefix = "T" + juce::String(track) + "_";
+    seed_pointers[track] = parameters.getRawParameterValue(prefix + "SEED");
+    seed_lock_pointers[track] =
+        parameters.getRawParameterValue(prefix + "SEED_LOCK");
+    track_length_pointers[track] =
+        parameters.getRawParameterValue(prefix + "TRACK_LENGTH");
+    page_pointers[track] = parameters.getRawParameterValue(prefix + "PAGE");
+    delay_pointers[track] = parameters.getRawParameterValue(prefix + "DELAY");
+    speed_pointers[track] = parameters.getRawParameterValue(prefix + "SPEED");
+    resync_pointers[track] = parameters.getRawParameterValue(prefix + "RESYNC");
+    play_mode_pointers[track] =
+        parameters.getRawParameterValue(prefix + "PLAY_MODE");
+    track_swing_pointers[track] =
+        parameters.getRawParameterValue(prefix + "SWING");
+    editPages[track] = 0;
+  }
+  input_latency_pointer = parameters.getRawParameterValue("INPUT_LATENCY");
+  master_length_pointer = parameters.getRawParameterValue("MASTER_LENGTH");
+  lookahead_pointer = parameters.getRawParameterValue("LOOKAHEAD");
+  swing_pointer = parameters.getRawParameterValue("SWING");
+  shared_clock_pointer = parameters.getRawParameterValue("SHARED_CLOCK");
+
+  // a host delays the other tracks by the reported latency, so no track has
+  // to be sent early (the standalone app has nobody to report to)
+  sequencer.setHostCompensatesLatency(
+      wrapperType != juce::AudioProcessor::WrapperType::wrapperType_Standalone);
+
   for (int track = 0; track < STEP_SEQ_NUM_MONO_TRACKS; ++track) {
-    for (int step = 0; step < STEP_SEQ_MAX_LENGTH; ++step) {
+    for (int step = 0; step < STEP_SEQ_PAGE_LENGTH; ++step) {
       juce::String prefix =
           "T" + juce::String(track) + "_S" + juce::String(step) + "_";
       mono_enabled_pointers[track][step] =
@@ -52,7 +93,7 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
     }
   }
   for (int track = 0; track < STEP_SEQ_NUM_POLY_TRACKS; ++track) {
-    for (int step = 0; step < STEP_SEQ_MAX_LENGTH; ++step) {
+    for (int step = 0; step < STEP_SEQ_PAGE_LENGTH; ++step) {
       juce::String prefix = "T" +
                             juce::String(track + STEP_SEQ_NUM_MONO_TRACKS) +
                             "_S" + juce::String(step) + "_";
@@ -77,72 +118,134 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
     }
   }
 
+  // called on the sequencer thread, the parameters (and the undo manager)
+  // are left to the message thread (see applyStepUpdates())
   sequencer.notifyProcessorMonoStepUpdate =
       [this](int track_index, int step_index, Sequencer::MonoStep step) {
-        undoManager.beginNewTransaction("Live recording note");
+        monoStepUpdates.push({track_index, step_index, step});
+      };
 
-        juce::String prefix = "T" + juce::String(track_index) + "_S" +
-                              juce::String(step_index) + "_";
-        auto p = parameters.getParameter(prefix + "ENABLED");
-        p->setValueNotifyingHost(static_cast<float>(step.enabled));
+  sequencer.notifyProcessorPolyStepUpdate =
+      [this](int track_index, int step_index, Sequencer::PolyStep step) {
+        polyStepUpdates.push({track_index, step_index, step});
+      };
+  HighResolutionTimer::startTimer(HIRES_TIMER_INTERVAL_MS);
+  Timer::startTimer(TIMER_INTERVAL_MS);
+}
 
-        p = parameters.getParameter(prefix + "NOTE");
-        p->setValueNotifyingHost(
-            p->convertTo0to1(static_cast<float>(step.note.number)));
+// steps recorded (or stolen) on the edited page are mirrored into the
+// parameters, steps on other pages are only kept by the sequencer
+void AudioPluginAudioProcessor::applyStepUpdates() {
+  StepUpdate<Sequencer::MonoStep> mono;
+  while (monoStepUpdates.pop(mono)) {
+    if (mono.step / STEP_SEQ_PAGE_LENGTH != editPages[mono.track])
+      continue;
+
+    undoManager.beginNewTransaction("Live recording note");
+    setMonoStepParameters(mono.track, mono.step % STEP_SEQ_PAGE_LENGTH,
+                          mono.value);
+  }
 
-        p = parameters.getParameter(prefix + "VELOCITY");
-        p->setValueNotifyingHost(
-            p->convertTo0to1(static_cast<float>(step.note.velocity)));
+  StepUpdate<Sequencer::PolyStep> poly;
+  while (polyStepUpdates.pop(poly)) {
+    if (poly.step / STEP_SEQ_PAGE_LENGTH !=
+        editPages[poly.track + STEP_SEQ_NUM_MONO_TRACKS])
+      continue;
 
-        p = parameters.getParameter(prefix + "OFFSET");
-        p->setValueNotifyingHost(p->convertTo0to1(step.note.offset));
+    undoManager.beginNewTransaction("Live recording note");
+    setPolyStepParameters(poly.track, poly.step % STEP_SEQ_PAGE_LENGTH,
+                          poly.value);
+  }
+}
 
-        p = parameters.getParameter(prefix + "LENGTH");
-        p->setValueNotifyingHost(p->convertTo0to1(step.note.length));
+// the sequencer works in ticks, parameters are in steps
+void AudioPluginAudioProcessor::setMonoStepParameters(
+    int track,
+    int slot,
+    const Sequencer::MonoStep& step) {
+  using Config = Sequencer::DefaultConfig;
 
-        p = parameters.getParameter(prefix + "RETRIGGER");
-        p->setValueNotifyingHost(p->convertTo0to1(step.retrigger_rate));
+  juce::String prefix =
+      "T" + juce::String(track) + "_S" + juce::String(slot) + "_";
+  auto p = parameters.getParameter(prefix + "ENABLED");
+  p->setValueNotifyingHost(static_cast<float>(step.enabled));
 
-        p = parameters.getParameter(prefix + "PROBABILITY");
-        p->setValueNotifyingHost(p->convertTo0to1(step.probability));
+  p = parameters.getParameter(prefix + "NOTE");
+  p->setValueNotifyingHost(
+      p->convertTo0to1(static_cast<float>(step.note.number)));
 
-        p = parameters.getParameter(prefix + "ALTERNATE");
-        p->setValueNotifyingHost(
-            p->convertTo0to1(static_cast<float>(step.alternate)));
-      };
+  p = parameters.getParameter(prefix + "VELOCITY");
+  p->setValueNotifyingHost(
+      p->convertTo0to1(static_cast<float>(step.note.velocity)));
 
-  sequencer.notifyProcessorPolyStepUpdate =
-      [this](int track_index, int step_index, Sequencer::PolyStep step) {
-        undoManager.beginNewTransaction("Live recording note");
+  p = parameters.getParameter(prefix + "OFFSET");
+  p->setValueNotifyingHost(
+      p->convertTo0to1(Config::ticksToSteps(step.note.offset_ticks)));
 
-        juce::String prefix =
-            "T" + juce::String(track_index + STEP_SEQ_NUM_MONO_TRACKS) + "_S" +
-            juce::String(step_index) + "_";
-        auto p = parameters.getParameter(prefix + "ENABLED");
-        p->setValueNotifyingHost(static_cast<float>(step.enabled));
+  p = parameters.getParameter(prefix + "LENGTH");
+  p->setValueNotifyingHost(
+      p->convertTo0to1(Config::ticksToSteps(step.note.length_ticks)));
 
-        p = parameters.getParameter(prefix + "PROBABILITY");
-        p->setValueNotifyingHost(p->convertTo0to1(step.probability));
+  p = parameters.getParameter(prefix + "RETRIGGER");
+  p->setValueNotifyingHost(
+      p->convertTo0to1(Config::ticksToSteps(step.retrigger_ticks)));
 
-        for (int i = 0; i < POLYPHONY; ++i) {
-          auto note_signifier = "N" + juce::String(i) + "_";
-          p = parameters.getParameter(prefix + note_signifier + "NOTE");
-          p->setValueNotifyingHost(
-              p->convertTo0to1(static_cast<float>(step.notes[i].number)));
+  p = parameters.getParameter(prefix + "PROBABILITY");
+  p->setValueNotifyingHost(p->convertTo0to1(step.probability));
 
-          p = parameters.getParameter(prefix + note_signifier + "VELOCITY");
-          p->setValueNotifyingHost(
-              p->convertTo0to1(static_cast<float>(step.notes[i].velocity)));
+  p = parameters.getParameter(prefix + "ALTERNATE");
+  p->setValueNotifyingHost(
+      p->convertTo0to1(static_cast<float>(step.alternate)));
+}
 
-          p = parameters.getParameter(prefix + note_signifier + "OFFSET");
-          p->setValueNotifyingHost(p->convertTo0to1(step.notes[i].offset));
+void AudioPluginAudioProcessor::setPolyStepParameters(
+    int track,
+    int slot,
+    const Sequencer::PolyStep& step) {
+  using Config = Sequencer::DefaultConfig;
+
+  juce::String prefix = "T" + juce::String(track + STEP_SEQ_NUM_MONO_TRACKS) +
+                        "_S" + juce::String(slot) + "_";
+  auto p = parameters.getParameter(prefix + "ENABLED");
+  p->setValueNotifyingHost(static_cast<float>(step.enabled));
+
+  p = parameters.getParameter(prefix + "PROBABILITY");
+  p->setValueNotifyingHost(p->convertTo0to1(step.probability));
+
+  for (int i = 0; i < POLYPHONY; ++i) {
+    auto note_signifier = "N" + juce::String(i) + "_";
+    p = parameters.getParameter(prefix + note_signifier + "NOTE");
+    p->setValueNotifyingHost(
+        p->convertTo0to1(static_cast<float>(step.notes[i].number)));
+
+    p = parameters.getParameter(prefix + note_signifier + "VELOCITY");
+    p->setValueNotifyingHost(
+        p->convertTo0to1(static_cast<float>(step.notes[i].velocity)));
+
+    p = parameters.getParameter(prefix + note_signifier + "OFFSET");
+    p->setValueNotifyingHost(p->convertTo0to1(
+        Config::ticksToSteps(step.notes[i].offset_ticks)));
+
+    p = parameters.getParameter(prefix + note_signifier + "LENGTH");
+    p->setValueNotifyingHost(p->convertTo0to1(
+        Config::ticksToSteps(step.notes[i].length_ticks)));
+  }
+}
 
-          p = parameters.getParameter(prefix + note_signifier + "LENGTH");
-          p->setValueNotifyingHost(p->convertTo0to1(step.notes[i].length));
-        }
-      };
-  HighResolutionTimer::startTimer(HIRES_TIMER_INTERVAL_MS);
-  Timer::startTimer(TIMER_INTERVAL_MS);
+void AudioPluginAudioProcessor::loadPageIntoParameters(int track) {
+  int first_step = editPages[track] * STEP_SEQ_PAGE_LENGTH;
+  for (int slot = 0; slot < STEP_SEQ_PAGE_LENGTH; ++slot) {
+    if (track < STEP_SEQ_NUM_MONO_TRACKS) {
+      setMonoStepParameters(
+          track, slot,
+          sequencer.getMonoTrack(track).getStepAtIndex(first_step + slot));
+    } else {
+      int poly_track = track - STEP_SEQ_NUM_MONO_TRACKS;
+      setPolyStepParameters(
+          poly_track, slot,
+          sequencer.getPolyTrack(poly_track).getStepAtIndex(first_step + slot));
+    }
+  }
 }
 
 const juce::String OffsetText[] = {
@@ -186,11 +289,91 @@ AudioPluginAudioProcessor::createParameterLayout() {
             return RetriggerText[index];
           });
 
+  auto page_attributes =
+      juce::AudioParameterIntAttributes{}.withStringFromValueFunction(
+          [](int value, int maximumStringLength) {
+            juce::ignoreUnused(maximumStringLength);
+            return juce::String(value * STEP_SEQ_PAGE_LENGTH + 1) + "-" +
+                   juce::String((value + 1) * STEP_SEQ_PAGE_LENGTH);
+          });
+
   // MARK: parameter layout
 
-  // mono tracks
+  // taken off the time of incoming notes when recording
+  layout.add(std::make_unique<AudioParameterFloat>(
+      "INPUT_LATENCY", "Input Latency",
+      NormalisableRange<float>(0.0f, MAX_INPUT_LATENCY_MS, 0.1f), 0.0f,
+      AudioParameterFloatAttributes{}.withLabel("ms")));
+
+  // tracks set to resync start over every master loop
+  layout.add(std::make_unique<AudioParameterInt>(
+      "MASTER_LENGTH", "Master Length", MASTER_LENGTH_MIN, STEP_SEQ_MAX_LENGTH,
+      STEP_SEQ_DEFAULT_LENGTH));
+
+  // steps rendered ahead (and so editable until they are sent)
+  layout.add(std::make_unique<AudioParameterInt>(
+      "LOOKAHEAD", "Lookahead", 0, LOOKAHEAD_STEPS_MAX,
+      LOOKAHEAD_STEPS_DEFAULT,
+      AudioParameterIntAttributes{}.withLabel("steps")));
+
+  // 50% is straight, 75% delays every other step by half a step
+  layout.add(std::make_unique<AudioParameterFloat>(
+      "SWING", "Swing",
+      NormalisableRange<float>(SWING_MIN_PERCENT, SWING_MAX_PERCENT, 1.0f),
+      SWING_MIN_PERCENT, AudioParameterFloatAttributes{}.withLabel("%")));
+
+  // instances on one machine play on the timeline of the leading one
+  layout.add(std::make_unique<AudioParameterChoice>(
+      "SHARED_CLOCK", "Shared Clock", StringArray{"Off", "Lead", "Follow"},
+      0));
+
+  StringArray speeds;
+  for (auto speed : Sequencer::TRACK_SPEEDS) {
+    speeds.add((speed.denominator == 1
+                    ? String(speed.numerator)
+                    : String(speed.numerator) + "/" +
+                          String(speed.denominator)) +
+               "x");
+  }
+
+  // per-track settings
+  for (int track = 0; track < STEP_SEQ_NUM_TRACKS; ++track) {
+    String prefix = "T" + String(track) + "_";
+    layout.add(std::make_unique<AudioParameterInt>(prefix + "SEED",
+                                                   "Random Seed", 0, 9999, 0));
+    layout.add(std::make_unique<AudioParameterBool>(prefix + "SEED_LOCK",
+                                                    "Seed Lock", false));
+    layout.add(std::make_unique<AudioParameterInt>(
+        prefix + "TRACK_LENGTH", "Track Length", 1, STEP_SEQ_MAX_LENGTH,
+        STEP_SEQ_DEFAULT_LENGTH));
+    layout.add(std::make_unique<AudioParameterInt>(
+        prefix + "PAGE", "Page", 0, STEP_SEQ_NUM_PAGES - 1, 0,
+        page_attributes));
+    layout.add(std::make_unique<AudioParameterFloat>(
+        prefix + "DELAY", "Delay",
+        NormalisableRange<float>(-MAX_TRACK_DELAY_MS, MAX_TRACK_DELAY_MS,
+                                 0.1f),
+        0.0f, AudioParameterFloatAttributes{}.withLabel("ms")));
+    layout.add(std::make_unique<AudioParameterChoice>(
+        prefix + "SPEED", "Speed", speeds,
+        Sequencer::TRACK_SPEED_DEFAULT_INDEX));
+    layout.add(std::make_unique<AudioParameterBool>(prefix + "RESYNC",
+                                                    "Resync", false));
+    // in the order of Track::PlayMode
+    layout.add(std::make_unique<AudioParameterChoice>(
+        prefix + "PLAY_MODE", "Play Mode",
+        StringArray{"Forward", "Backward", "Random", "Bounce", "Brownian"},
+        0));
+    // on top of the global swing
+    layout.add(std::make_unique<AudioParameterFloat>(
+        prefix + "SWING", "Swing",
+        NormalisableRange<float>(SWING_MIN_PERCENT, SWING_MAX_PERCENT, 1.0f),
+        SWING_MIN_PERCENT, AudioParameterFloatAttributes{}.withLabel("%")));
+  }
+
+  // mono tracks (one page of steps, see T{t}_PAGE)
   for (int track = 0; track < STEP_SEQ_NUM_MONO_TRACKS; ++track) {
-    for (int step = 0; step < STEP_SEQ_MAX_LENGTH; ++step) {
+    for (int step = 0; step < STEP_SEQ_PAGE_LENGTH; ++step) {
       String prefix = "T" + String(track) + "_S" + String(step) + "_";
       layout.add(std::make_unique<AudioParameterBool>(prefix + "ENABLED",
                                                       "Enabled", false));
@@ -208,7 +391,7 @@ AudioPluginAudioProcessor::createParameterLayout() {
 
       layout.add(std::make_unique<AudioParameterFloat>(
           prefix + "LENGTH", "Length",
-          NormalisableRange<float>(0.08f, STEP_SEQ_MAX_LENGTH, 0.01f, 0.5f),
+          NormalisableRange<float>(0.08f, MAX_NOTE_LENGTH, 0.01f, 0.5f),
           static_cast<float>(DEFAULT_LENGTH)));
 
       layout.add(std::make_unique<AudioParameterFloat>(
@@ -225,10 +408,10 @@ AudioPluginAudioProcessor::createParameterLayout() {
     }
   }
 
-  // poly tracks
+  // poly tracks (one page of steps, see T{t}_PAGE)
   for (int track = STEP_SEQ_NUM_MONO_TRACKS; track < STEP_SEQ_NUM_TRACKS;
        ++track) {
-    for (int step = 0; step < STEP_SEQ_MAX_LENGTH; ++step) {
+    for (int step = 0; step < STEP_SEQ_PAGE_LENGTH; ++step) {
       String prefix = "T" + String(track) + "_S" + String(step) + "_";
       layout.add(std::make_unique<AudioParameterBool>(prefix + "ENABLED",
                                                       "Enabled", false));
@@ -250,7 +433,7 @@ AudioPluginAudioProcessor::createParameterLayout() {
 
       layout.add(std::make_unique<AudioParameterFloat>(
           prefix + "N0_LENGTH", "Length",
-          NormalisableRange<float>(0.08f, STEP_SEQ_MAX_LENGTH, 0.01f, 0.5f),
+          NormalisableRange<float>(0.08f, MAX_NOTE_LENGTH, 0.01f, 0.5f),
           static_cast<float>(DEFAULT_LENGTH)));
 
       for (int note = 1; note < POLYPHONY; ++note) {
@@ -270,7 +453,7 @@ AudioPluginAudioProcessor::createParameterLayout() {
 
         layout.add(std::make_unique<AudioParameterFloat>(
             prefix + note_signifier + "LENGTH", "Length",
-            NormalisableRange<float>(0.08f, STEP_SEQ_MAX_LENGTH, 0.01f, 0.5f),
+            NormalisableRange<float>(0.08f, MAX_NOTE_LENGTH, 0.01f, 0.5f),
             static_cast<float>(DEFAULT_LENGTH)));
       }
     }
@@ -279,27 +462,93 @@ AudioPluginAudioProcessor::createParameterLayout() {
 }
 
 void AudioPluginAudioProcessor::timerCallback() {
+  using Config = Sequencer::DefaultConfig;
+
+  // first, so the steps copied from the parameters below already have them
+  applyStepUpdates();
+
   // apply sequencer parameter changes from GUI update
+  // float step values are converted to ticks here on the message thread, so
+  // the tick path only ever sees integers
+  bool page_changed[STEP_SEQ_NUM_TRACKS];
+  for (int i = 0; i < STEP_SEQ_NUM_TRACKS; ++i) {
+    auto& track = sequencer.getTrackByChannel(i + 1);
+    track.setSeed(static_cast<uint32_t>(*(seed_pointers[i])));
+    track.setSeedLocked(static_cast<bool>(*(seed_lock_pointers[i])));
+    track.setLength(static_cast<int>(*(track_length_pointers[i])));
+    sequencer.setTrackDelay(i + 1, static_cast<double>(*(delay_pointers[i])));
+    track.setSpeed(
+        Sequencer::TRACK_SPEEDS[static_cast<int>(*(speed_pointers[i]))]);
+    track.setSyncMode(static_cast<bool>(*(resync_pointers[i]))
+                          ? Sequencer::Track::SyncMode::MasterLoop
+                          : Sequencer::Track::SyncMode::Free);
+    track.setPlayMode(static_cast<Sequencer::Track::PlayMode>(
+        static_cast<int>(*(play_mode_pointers[i]))));
+    sequencer.setTrackSwing(i + 1, *(track_swing_pointers[i]) * 0.01f);
+
+    // another page was selected: the parameters take the steps of that page
+    // this round instead of being written into it
+    int page = static_cast<int>(*(page_pointers[i]));
+    page_changed[i] = page != editPages[i];
+    if (page_changed[i]) {
+      editPages[i] = page;
+      loadPageIntoParameters(i);
+    }
+  }
+
+  inputClock.setLatency(*input_latency_pointer * 0.001);
+  sequencer.setMasterLength(static_cast<int>(*master_length_pointer));
+  sequencer.setLookahead(static_cast<int>(*lookahead_pointer));
+  sequencer.setSwing(*swing_pointer * 0.01f);
+
+  int shared_clock_role = static_cast<int>(*shared_clock_pointer);
+  if (shared_clock_role != sharedClockRole) {
+    sharedClockRole = shared_clock_role;
+    auto* clock = sharedClockRole != 0 ? openSharedClock() : nullptr;
+    sequencer.setSharedClock(
+        clock, sharedClockRole == 1
+                   ? Sequencer::E3Sequencer::SharedClockRole::Lead
+                   : Sequencer::E3Sequencer::SharedClockRole::Follow);
+  }
+
+  int latency = juce::roundToInt(sequencer.getLatency() * getSampleRate());
+  if (latency != getLatencySamples()) {
+    setLatencySamples(latency);
+  }
+
   for (int i = 0; i < STEP_SEQ_NUM_MONO_TRACKS; ++i) {
-    for (int j = 0; j < STEP_SEQ_MAX_LENGTH; ++j) {
+    if (page_changed[i])
+      continue;
+
+    int first_step = editPages[i] * STEP_SEQ_PAGE_LENGTH;
+    for (int j = 0; j < STEP_SEQ_PAGE_LENGTH; ++j) {
       Sequencer::MonoStep step{
           .enabled = static_cast<bool>(*(mono_enabled_pointers[i][j])),
           .note = {.number = static_cast<int>(*(mono_note_pointers[i][j])),
                    .velocity =
                        static_cast<int>(*(mono_velocity_pointers[i][j])),
-                   .offset = *(mono_offset_pointers[i][j]),
-                   .length = *(mono_length_pointers[i][j])},
-          .retrigger_rate = *(mono_retrigger_pointers[i][j]),
+                   .offset_ticks =
+                       Config::offsetToTicks(*(mono_offset_pointers[i][j])),
+                   .length_ticks =
+                       Config::lengthToTicks(*(mono_length_pointers[i][j]))},
+          .retrigger_ticks =
+              Config::stepsToTicks(*(mono_retrigger_pointers[i][j])),
           .probability = *(mono_probability_pointers[i][j]),
           .alternate = static_cast<int>(*(mono_alternate_pointers[i][j])),
       };
-      sequencer.getMonoTrack(i).setStepAtIndex(j, step, true);
+      sequencer.getMonoTrack(i).setStepAtIndex(first_step + j, step, true);
     }
   }
 
   for (int i = 0; i < STEP_SEQ_NUM_POLY_TRACKS; ++i) {
-    for (int j = 0; j < STEP_SEQ_MAX_LENGTH; ++j) {
-      Sequencer::PolyStep step = sequencer.getPolyTrack(i).getStepAtIndex(j);
+    if (page_changed[i + STEP_SEQ_NUM_MONO_TRACKS])
+      continue;
+
+    int first_step = editPages[i + STEP_SEQ_NUM_MONO_TRACKS] *
+                     STEP_SEQ_PAGE_LENGTH;
+    for (int j = 0; j < STEP_SEQ_PAGE_LENGTH; ++j) {
+      Sequencer::PolyStep step =
+          sequencer.getPolyTrack(i).getStepAtIndex(first_step + j);
       step.enabled = static_cast<bool>(*(poly_enabled_pointers[i][j]));
       step.probability = *(poly_probability_pointers[i][j]);
 
@@ -307,12 +556,39 @@ void AudioPluginAudioProcessor::timerCallback() {
         step.notes[n].number = static_cast<int>(*(poly_note_pointers[i][j][n]));
         step.notes[n].velocity =
             static_cast<int>(*(poly_velocity_pointers[i][j][n]));
-        step.notes[n].offset = *(poly_offset_pointers[i][j][n]);
-        step.notes[n].length = *(poly_length_pointers[i][j][n]);
+        step.notes[n].offset_ticks =
+            Config::offsetToTicks(*(poly_offset_pointers[i][j][n]));
+        step.notes[n].length_ticks =
+            Config::lengthToTicks(*(poly_length_pointers[i][j][n]));
       }
-      sequencer.getPolyTrack(i).setStepAtIndex(j, step);
+      sequencer.getPolyTrack(i).setStepAtIndex(first_step + j, step);
+    }
+  }
+}
+
+Sequencer::SharedClock* AudioPluginAudioProcessor::openSharedClock() {
+  if (sharedClockFile == nullptr) {
+    // the name carries the layout, so another build does not misread it
+    constexpr auto size =
+        static_cast<juce::int64>(sizeof(Sequencer::SharedClock));
+    auto file = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                    .getChildFile("E3Seq-shared-clock-" + juce::String(size));
+    if (file.getSize() < size) {
+      // all zero is a stopped clock (appended, another instance may have
+      // written part of it already)
+      juce::FileOutputStream out(file);
+      if (!out.openedOk() ||
+          !out.writeRepeatedByte(0, static_cast<size_t>(size - file.getSize())))
+        return nullptr;
     }
+    sharedClockFile = std::make_unique<juce::MemoryMappedFile>(
+        file, juce::MemoryMappedFile::readWrite);
   }
+
+  if (sharedClockFile->getData() == nullptr ||
+      sharedClockFile->getSize() < sizeof(Sequencer::SharedClock))
+    return nullptr;
+  return static_cast<Sequencer::SharedClock*>(sharedClockFile->getData());
 }
 
 void AudioPluginAudioProcessor::hiResTimerCallback() {
@@ -460,13 +736,70 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
   }
   // MARK: process MIDI
 
-  // process MIDI start/stop/continue messages
+  lastCallbackTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
+  inputClock.beginBlock(lastCallbackTime, buffer.getNumSamples(),
+                        getSampleRate());
+
+  // follow the DAW transport: tempo, and the play position of every block
+  // (unless an external MIDI clock or the shared clock is followed)
+  juce::Optional<double> ppq;
+  double bpm = sequencer.getBpm();
+  if (this->wrapperType ==
+          juce::AudioProcessor::WrapperType::wrapperType_VST3 &&
+      !sequencer.isSyncedToMidiClock() && !sequencer.isFollowingSharedClock()) {
+    if (auto dawPlayHead = getPlayHead()) {
+      if (auto positionInfo = dawPlayHead->getPosition()) {
+        bpm = positionInfo->getBpm().orFallback(120.0);
+        sequencer.setBpm(bpm);
+
+        ppq = positionInfo->getPpqPosition();
+        if (!ppq) {
+          if (auto samples = positionInfo->getTimeInSamples()) {
+            ppq = static_cast<double>(*samples) / getSampleRate() * bpm /
+                  60.0;
+          }
+        }
+        sequencer.setSyncToHost(ppq.hasValue());
+
+        if (ppq) {
+          // what is stamped now goes to the start of the next block (see
+          // juce::MidiMessageCollector), so that is the position to line up
+          double block_quarters =
+              buffer.getNumSamples() / getSampleRate() * bpm / 60.0;
+          sequencer.setHostPosition(*ppq + block_quarters, lastCallbackTime,
+                                    positionInfo->getIsPlaying());
+        } else if (positionInfo->getIsPlaying()) {
+          if (!sequencer.isRunning())
+            sequencer.start(juce::Time::getMillisecondCounterHiRes() * 0.001);
+        } else {
+          if (sequencer.isRunning())
+            sequencer.stop();
+        }
+      }
+    }
+  }
+
+  // the tick a note at {sample} into the block was played at: straight from
+  // the host position when there is one, otherwise through the input clock
+  auto input_tick = [&](int sample) {
+    if (ppq) {
+      double seconds = sample / getSampleRate() - inputClock.getLatency();
+      return (*ppq + seconds * bpm / 60.0) * TICKS_PER_STEP * 4;
+    }
+    return sequencer.getTickAtTime(inputClock.getTime(sample));
+  };
+
+  // process MIDI start/stop/continue messages, and notes to record
   for (const auto metadata : midiMessages) {
     auto message = metadata.getMessage();
+    auto time_stamp_in_seconds = inputClock.getTime(metadata.samplePosition);
 
-    // auto current_time = juce::Time::getMillisecondCounter() * 0.001;
-    auto time_stamp_in_seconds =
-        message.getTimeStamp() / getSampleRate() + lastCallbackTime;
+    // (a follower of the shared clock takes the transport from there)
+    if ((message.isMidiStart() || message.isMidiStop() ||
+         message.isMidiContinue()) &&
+        sequencer.isFollowingSharedClock()) {
+      continue;
+    }
 
     if (message.isMidiStart()) {
       sequencer.start(time_stamp_in_seconds);
@@ -475,40 +808,22 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
     } else if (message.isMidiContinue()) {
       sequencer.resume();
     }
-    // TODO: midi clock sync
-    else if (message.isNoteOn()) {
-      message.setTimeStamp(time_stamp_in_seconds);
+    else if (message.isMidiClock()) {
+      sequencer.handleMidiClock(time_stamp_in_seconds);
+    } else if (message.isNoteOn()) {
+      message.setTimeStamp(input_tick(metadata.samplePosition));
       sequencer.handleNoteOn(message);
     } else if (message.isNoteOff()) {
-      message.setTimeStamp(time_stamp_in_seconds);
+      message.setTimeStamp(input_tick(metadata.samplePosition));
       sequencer.handleNoteOff(message);
     }
   }
 
-  lastCallbackTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
-
-  // generate MIDI start/stop/continue messages by querying DAW transport
-  // also set bpm
-  if (this->wrapperType ==
-      juce::AudioProcessor::WrapperType::wrapperType_VST3) {
-    if (auto dawPlayHead = getPlayHead()) {
-      if (auto positionInfo = dawPlayHead->getPosition()) {
-        sequencer.setBpm(positionInfo->getBpm().orFallback(120.0));
-
-        if (positionInfo->getIsPlaying()) {
-          if (!sequencer.isRunning())
-            sequencer.start(juce::Time::getMillisecondCounterHiRes() * 0.001);
-        } else {
-          if (sequencer.isRunning())
-            sequencer.stop();
-        }
-      }
-    }
-  }
-
   // midiMessages.clear();  // discard input MIDI messages
 
   // overwrite MIDI buffer
+  // (with the sequencer's events that are due by now, see OutputQueue.h)
+  sequencer.releaseDueEvents();
   seqMidiCollector.removeNextBlockOfMessages(midiMessages, getBlockSize());
   guiMidiCollector.removeNextBlockOfMessages(midiMessages, getBlockSize());
   // visualize MIDI in all channels and manual trigger
@@ -542,9 +857,7 @@ void AudioPluginAudioProcessor::getStateInformation(
   if (this->wrapperType ==
       juce::AudioProcessor::WrapperType::wrapperType_Standalone)
     return;  // only recall parameters if run inside a DAW
-  auto state = parameters.copyState();
-  std::unique_ptr<juce::XmlElement> xml(state.createXml());
-  copyXmlToBinary(*xml, destData);
+  copyXmlToBinary(*createStateXml(), destData);
 }
 
 void AudioPluginAudioProcessor::setStateInformation(const void* data,
@@ -556,26 +869,59 @@ void AudioPluginAudioProcessor::setStateInformation(const void* data,
       getXmlFromBinary(data, sizeInBytes));
   if (xmlState.get() != nullptr) {
     if (xmlState->hasTagName(parameters.state.getType())) {
-      parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+      restoreState(*xmlState);
     }
   }
 }
 
 void AudioPluginAudioProcessor::savePreset(const juce::File& file) {
-  auto state = parameters.copyState();
-  std::unique_ptr<juce::XmlElement> xml(state.createXml());
-  xml->writeTo(file);
+  createStateXml()->writeTo(file);
 }
 
 void AudioPluginAudioProcessor::loadPreset(const juce::File& file) {
   std::unique_ptr<juce::XmlElement> xml = juce::XmlDocument::parse(file);
   if (xml != nullptr && xml->hasTagName(parameters.state.getType())) {
-    parameters.replaceState(juce::ValueTree::fromXml(*xml));
+    restoreState(*xml);
   }
 }
 
 void AudioPluginAudioProcessor::resetToDefaultState() {
+  sequencer.clearSteps();
   parameters.replaceState(juce::ValueTree(parameters.state.getType()));
+  for (auto& page : editPages) {
+    page = -1;
+  }
+}
+
+// MARK: state
+std::unique_ptr<juce::XmlElement> AudioPluginAudioProcessor::createStateXml() {
+  auto state = parameters.copyState();
+  std::unique_ptr<juce::XmlElement> xml(state.createXml());
+  xml->addChildElement(Sequencer::PatternState::write(sequencer).release());
+  return xml;
+}
+
+void AudioPluginAudioProcessor::restoreState(const juce::XmlElement& xml) {
+  // the pattern lives in the sequencer, not in the parameter tree
+  auto tree = juce::ValueTree::fromXml(xml);
+  tree.removeChild(tree.getChildWithName(Sequencer::PatternState::TAG),
+                   nullptr);
+  parameters.replaceState(tree);
+
+  if (auto* pattern = xml.getChildByName(Sequencer::PatternState::TAG)) {
+    Sequencer::PatternState::read(*pattern, sequencer);
+    // refill the parameters from the pattern on the next timer callback
+    for (auto& page : editPages) {
+      page = -1;
+    }
+  } else {
+    // saved before paging: the parameters are the whole pattern (page 0), so
+    // let the next timer callback write them into the emptied sequencer
+    sequencer.clearSteps();
+    for (int track = 0; track < STEP_SEQ_NUM_TRACKS; ++track) {
+      editPages[track] = static_cast<int>(*(page_pointers[track]));
+    }
+  }
 }
 
 }  // namespace audio_plugin
@@ -5,48 +5,52 @@ namespace Sequencer {
 // Warning: data race if setStepAtIndex() and tick() are called from different
 // threads
 
-int Track::getCurrentStepIndex() const {
-  return (tick_ + HALF_STEP_TICKS) / TICKS_PER_STEP;
+template <typename Config>
+int BasicTrack<Config>::getCurrentStepIndex() const {
+  return getPlayOrder()[(tick_ + HALF_STEP_TICKS) / ticksPerStep];
 }
 
-void Track::renderNote(int index, Note note) {
-  if (note.number <= DISABLED_NOTE)
+template <typename Config>
+int BasicTrack<Config>::getStepIndexAt(juce::int64 tick) const {
+  juce::int64 loop_ticks = trackLength_ * ticksPerStep;
+  auto track = static_cast<juce::int64>(
+      std::floor(getTrackTick(static_cast<double>(tick))));
+  // the slot in the loop of the render position or the one before, further
+  // away the loops are taken to repeat
+  const Order* order = &order_;
+  juce::int64 position = track - loopStart_ + HALF_STEP_TICKS;
+  if (position < 0) {
+    order = &previousOrder_;
+    position = track - previousLoopStart_ + HALF_STEP_TICKS;
+  }
+  position %= loop_ticks;
+  if (position < 0) {
+    position += loop_ticks;
+  }
+  return (*order)[static_cast<size_t>(position / ticksPerStep)];
+}
+
+template <typename Config>
+void BasicTrack<Config>::renderNote(int index, Note note) {
+  if (note.number <= DISABLED_NOTE || !hasRoomFor(2))
     return;
 
-  int note_on_tick = static_cast<int>((index + note.offset) * TICKS_PER_STEP);
-  int note_off_tick =
-      static_cast<int>((index + note.offset + note.length) * TICKS_PER_STEP);
+  int note_on_tick = index * ticksPerStep + note.offset_ticks;
+  int note_off_tick = note_on_tick + note.length_ticks;
 
   // force note off before the next note on of the same note
-  // search all midi messages after note_on_tick
-  // if there is a note off with the same note number
-  // delete that and insert a new note off at note_on_tick
-
-  bool note_off_deleted = false;
-  for (int i = firstRun_.getNextIndexAtTime(tick_);
-       i < firstRun_.getNumEvents(); ++i) {
-    auto message = firstRun_.getEventPointer(i)->message;
-    if (message.isNoteOff() && message.getNoteNumber() == note.number) {
-      firstRun_.deleteEvent(i, false);
-      note_off_deleted = true;
-    }
-  }
-
-  if (!note_off_deleted) {  // search second run
-    for (int i = 0; i < secondRun_.getNumEvents(); ++i) {
-      auto message = secondRun_.getEventPointer(i)->message;
-      if (message.isNoteOff() && message.getNoteNumber() == note.number) {
-        secondRun_.deleteEvent(i, false);
-        note_off_deleted = true;
-      }
-    }
-  }
-
-  if (note_off_deleted) {
+  // if a note off of the same note number is still waiting after note_on_tick
+  // (in this or any later loop), drop it and end the note at note_on_tick
+  // instead (the new note off keeps the tag of the step that played the note,
+  // so taking this step back does not leave that note hanging)
+  juce::int64 note_on = renderLoopStart_ + renderShift_ + note_on_tick;
+  if (auto owner = events_.removeNoteOffs(note.number, note_on)) {
     juce::MidiMessage early_note_off_message = juce::MidiMessage::noteOff(
         getChannel(), note.number, (juce::uint8)note.velocity);
-    early_note_off_message.setTimeStamp(note_on_tick);  // -1?
-    renderMidiMessage(early_note_off_message);
+    // at the note on itself rather than a tick before: events of one tick
+    // keep the order they were added in, so this still goes out first,
+    // without cutting the note short (a one tick note would lose it all)
+    events_.add(early_note_off_message, note_on, *owner, getSendTick());
   }
 
   // note on
@@ -62,58 +66,432 @@ void Track::renderNote(int index, Note note) {
   renderMidiMessage(note_off_message);
 }
 
-// insert a future MIDI message into the MIDI buffer based on its timestamp
-void Track::renderMidiMessage(juce::MidiMessage message) {
-  int tick = static_cast<int>(message.getTimeStamp());
+// insert a future MIDI message into the timeline based on its timestamp
+template <typename Config>
+void BasicTrack<Config>::renderMidiMessage(juce::MidiMessage message) {
+  auto tick = static_cast<juce::int64>(message.getTimeStamp());
+  events_.add(message, renderLoopStart_ + renderShift_ + tick, renderingStep_,
+              getSendTick());
+}
 
-  if (tick < trackLength_ * TICKS_PER_STEP - HALF_STEP_TICKS) {
-    firstRun_.addEvent(message);
+template <typename Config>
+int BasicTrack<Config>::getNextNoteOnTick() const {
+  const Order& order = renderInPreviousLoop_ ? previousOrder_ : order_;
+  Direction direction =
+      renderInPreviousLoop_ ? previousDirection_ : orderDirection_;
+  int swing = renderInPreviousLoop_ ? previousSwing_ : orderSwing_;
+  int length = trackLength_;
 
-  } else {
-    message.setTimeStamp(tick - trackLength_ * TICKS_PER_STEP);
-    secondRun_.addEvent(message);
+  // the rest of this loop
+  int slot = findEnabledSlot(order, direction, renderSlot_ + 1, length);
+  if (slot >= 0) {
+    int index = getSlotStep(order, direction, slot);
+    return renderTicks_[index] + getSlotShift(slot, index, swing) -
+           renderShift_;
   }
+
+  // the next loop up to this slot (the current order again, or turned
+  // around)
+  Direction next_direction = orderDirection_;
+  if (!renderInPreviousLoop_ && orderMode_ == PlayMode::Bounce) {
+    next_direction = direction == Direction::Forward ? Direction::Backward
+                                                     : Direction::Forward;
+  }
+  slot = findEnabledSlot(order_, next_direction, 0, renderSlot_);
+  if (slot >= 0) {
+    int index = getSlotStep(order_, next_direction, slot);
+    return renderTicks_[index] + length * ticksPerStep +
+           getSlotShift(slot, index, orderSwing_) - renderShift_;
+  }
+  return NOT_RENDERED;
 }
 
-void Track::returnToStart() {
-  firstRun_.clear();
-  secondRun_.clear();
+template <typename Config>
+int BasicTrack<Config>::findEnabledSlot(const Order& order,
+                                        Direction direction,
+                                        int begin,
+                                        int end) const {
+  int length = trackLength_;
+  switch (direction) {
+    case Direction::Forward:
+      return enabledSteps_.findFirst(begin, end);
+    case Direction::Backward: {
+      // the slots run through the steps from the last one down
+      int index = enabledSteps_.findLast(length - end, length - begin);
+      return index >= 0 ? length - 1 - index : -1;
+    }
+    case Direction::Drawn:
+      break;
+  }
+  for (int slot = begin; slot < end; ++slot) {
+    if (renderTicks_[order[static_cast<size_t>(slot)]] != NOT_RENDERED) {
+      return slot;
+    }
+  }
+  return -1;
+}
+
+template <typename Config>
+void BasicTrack<Config>::returnToStart() {
+  events_.clear();
+  editedSteps_.take();
+  pendingTick_ = NOT_RENDERED;
+  renderedStep_ = NO_STEP;
   tick_ = 0;
+  absoluteTick_ = 0;
+  renderTick_ = 0;
+  loopStart_ = 0;
+  previousLoopStart_ = 0;
+
+  speed_ = requestedSpeed_.load();
+  updateTrackDelay();
+  sequencerTick_ = 0;
+  anchorTick_ = 0;
+  anchorTrack_ = 0;
+  budget_ = 0;
+  resyncTicks_ =
+      syncMode_.load() == SyncMode::MasterLoop ? masterLoop_.load() : 0;
+  scheduleResync(0);
+  applySeed(true);
+  fillOrder(true);
+  playInPreviousLoop_ = false;
 }
 
-void Track::tick() {
-  if (this->enabled_) {
-    int index = getCurrentStepIndex();
+template <typename Config>
+void BasicTrack<Config>::locate(juce::int64 tick) {
+  // the track has played from the start of the master loop (or from the
+  // very start when it runs free) at its current speed
+  sequencerTick_ = tick;
+  anchorTick_ = resyncTicks_ > 0 ? tick - tick % resyncTicks_ : 0;
+  anchorTrack_ = 0;
+  juce::int64 track = getTrackTickAt(tick);
+  budget_ = static_cast<int>((tick - anchorTick_) * speed_.numerator -
+                             track * speed_.denominator);
+  scheduleResync(tick);
+
+  absoluteTick_ = track;
+  // (after what was sent ahead, which may still be a note on)
+  events_.clearEndingNotes([this](const juce::MidiMessage& message) {
+    sendEvent(message.withTimeStamp(
+        static_cast<double>(getSendTick() + getSendAhead())));
+  });
+  editedSteps_.take();
+  pendingTick_ = NOT_RENDERED;
+  renderedStep_ = NO_STEP;
 
-    // render the step just right before it's too late
-    if (tick_ == getStepRenderTick(index)) {
-      renderStep(index);
+  int loop_ticks = trackLength_ * ticksPerStep;
+  loopStart_ = track - track % loop_ticks;
+  previousLoopStart_ = loopStart_ - loop_ticks;
+  renderTick_ = static_cast<int>(track - loopStart_);
+  // (the render position wraps half a step before the end of the loop, or
+  // of the master loop)
+  bool resync = track + HALF_STEP_TICKS >= renderResyncTrack_;
+  if (renderTick_ >= loop_ticks - HALF_STEP_TICKS || resync) {
+    previousLoopStart_ = loopStart_;
+    loopStart_ = resync ? renderResyncTrack_ : loopStart_ + loop_ticks;
+    renderTick_ = static_cast<int>(track - loopStart_);
+    if (resync) {
+      scheduleResync(renderResyncTick_);
     }
+  }
+  tick_ = renderTick_;
 
-    // send current tick's MIDI events
-    for (int i = firstRun_.getNextIndexAtTime(tick_);
-         i < firstRun_.getNextIndexAtTime(tick_ + 1); ++i) {
-      auto message = firstRun_.getEventPointer(i)->message;
+  applySeed(seedLocked_.load());
+  // (a jump starts the play order over)
+  fillOrder(true);
+  playInPreviousLoop_ = false;
+}
 
-      // do not note off if held by the keyboard
-      if (message.isNoteOff() &&
-          keyboardRef.isNoteOn(message.getNoteNumber())) {
-        continue;
-      }
+template <typename Config>
+void BasicTrack<Config>::tick() {
+  applySpeed();
+
+  // a master loop starts: the render position started the loop over at the
+  // track tick due now
+  if (resyncTicks_ > 0 && sequencerTick_ % resyncTicks_ == 0) {
+    anchor(sequencerTick_, getTrackTickAt(sequencerTick_));
+  }
+
+  budget_ += speed_.numerator;
+  while (budget_ > 0) {
+    advance();
+    budget_ -= speed_.denominator;
+  }
+  ++sequencerTick_;
+}
+
+template <typename Config>
+void BasicTrack<Config>::applySpeed() {
+  int resync =
+      syncMode_.load() == SyncMode::MasterLoop ? masterLoop_.load() : 0;
+  if (resync != resyncTicks_) {
+    resyncTicks_ = resync;
+    scheduleResync(sequencerTick_);
+  }
+
+  TrackSpeed speed = requestedSpeed_.load();
+  if (speed == speed_)
+    return;
+
+  // the next tick of the track plays now, at the new speed from there on
+  // (the master loop the render position is heading for stays the same,
+  // unless it already started it over)
+  speed_ = speed;
+  anchor(sequencerTick_, absoluteTick_);
+  updateTrackDelay();
+  if (renderResyncTick_ != NO_RESYNC) {
+    renderResyncTrack_ = getTrackTickAt(renderResyncTick_);
+  }
+}
+
+template <typename Config>
+void BasicTrack<Config>::anchor(juce::int64 tick, juce::int64 track) {
+  while (absoluteTick_ < track) {
+    advance();
+  }
+  anchorTick_ = tick;
+  anchorTrack_ = track;
+  budget_ = -speed_.denominator * static_cast<int>(absoluteTick_ - track);
+}
+
+template <typename Config>
+void BasicTrack<Config>::scheduleResync(juce::int64 tick) {
+  if (resyncTicks_ == 0) {
+    renderResyncTick_ = NO_RESYNC;
+    renderResyncTrack_ = NO_RESYNC;
+    return;
+  }
+  renderResyncTick_ = (tick / resyncTicks_ + 1) * resyncTicks_;
+  renderResyncTrack_ = getTrackTickAt(renderResyncTick_);
+}
 
-      sendMidiMessage(message);
+template <typename Config>
+void BasicTrack<Config>::advance() {
+  // (after a step rendered in parts is done)
+  if (pendingTick_ == NOT_RENDERED) {
+    auto edited = editedSteps_.take();
+    if (edited.any()) {
+      rerenderEditedSteps(edited);
     }
   }
 
-  // advance ticks and overwrap from (length-0.5) to (-0.5) step
-  // because the first step could start from negative steps
-  tick_ += 1;
-  if (tick_ == trackLength_ * TICKS_PER_STEP - HALF_STEP_TICKS) {
-    tick_ = -HALF_STEP_TICKS;
-    // move second run into first run
-    firstRun_.swapWith(secondRun_);
-    secondRun_.clear();
+  // render everything up to the lookahead, plus what a negative delay sends
+  // early (less than a loop, so the play position is never more than one
+  // loop behind)
+  int ahead = lookaheadTicks_.load() + std::max(-trackDelay_, 0);
+  int loop_ticks = trackLength_ * ticksPerStep;
+  if (resyncTicks_ > 0) {
+    loop_ticks = std::min(loop_ticks, resyncTicks_ * speed_.numerator /
+                                          speed_.denominator);
   }
+  juce::int64 render_until = absoluteTick_ + std::min(ahead, loop_ticks - 1);
+  while (loopStart_ + renderTick_ <= render_until) {
+    if (this->enabled_) {
+      renderAt(renderTick_);
+    }
+    advanceRenderTick();
+  }
+
+  // send the MIDI events of the current tick (shifted by the delay) and the
+  // ones just ahead of it, which wait in the output until they are due
+  // (a disabled track drops them, like it always did)
+  events_.popDue(getSendTick() + getSendAhead(),
+                 [this](const juce::MidiMessage& message) {
+                   sendEvent(message);
+                 });
+
+  // advance the play position, which is in the render position's loop or
+  // (while that just wrapped) in the one before
+  absoluteTick_ += 1;
+  juce::int64 position = absoluteTick_ - loopStart_;
+  playInPreviousLoop_ = position < -HALF_STEP_TICKS;
+  if (playInPreviousLoop_) {
+    position = absoluteTick_ - previousLoopStart_;
+  }
+  tick_ = static_cast<int>(position);
+}
+
+template <typename Config>
+void BasicTrack<Config>::sendEvent(const juce::MidiMessage& message) {
+  // do not note off if held by the keyboard
+  if (!this->enabled_ ||
+      (message.isNoteOff() && keyboardRef.isNoteOn(message.getNoteNumber()))) {
+    return;
+  }
+
+  auto track = static_cast<juce::int64>(message.getTimeStamp());
+  sendMidiMessage(message.withTimeStamp(getSequencerTick(track) +
+                                        static_cast<double>(delayTicks_)));
 }
 
+template <typename Config>
+void BasicTrack<Config>::renderAt(int tick) {
+  int slot = (tick + HALF_STEP_TICKS) / ticksPerStep;
+  int index = order_[slot];
+  setRenderSlot(loopStart_, slot, index, false);
+
+  // render the step just right before it's too late, as if it was in its own
+  // place (disabled steps are NOT_RENDERED and never match)
+  // a swung step renders on the straight grid, its events are moved later
+  // a step whose first note moved later while it played (stolen, or edited)
+  // is not rendered again in the same slot, the rest of it is pending
+  int step_tick = tick - (slot - index) * ticksPerStep;
+  if (step_tick == renderTicks_[index] && renderingStep_ != renderedStep_) {
+    renderedStep_ = renderingStep_;
+    renderStep(index);
+  } else if (step_tick == pendingTick_) {
+    renderPending(step_tick);
+  }
+}
+
+// advance ticks and overwrap from (length-0.5) to (-0.5) step
+// because the first step could start from negative steps
+// (>= since the track might just have been shortened behind the render
+// position)
+// a master loop (see setSyncMode()) wraps the same way, half a step before
+// the track tick it starts at
+template <typename Config>
+void BasicTrack<Config>::advanceRenderTick() {
+  renderTick_ += 1;
+  bool resync =
+      loopStart_ + renderTick_ + HALF_STEP_TICKS >= renderResyncTrack_;
+  if (renderTick_ >= trackLength_ * ticksPerStep - HALF_STEP_TICKS ||
+      resync) {
+    // the next loop starts here whatever the length was, events already on
+    // the timeline keep their absolute tick
+    previousLoopStart_ = loopStart_;
+    loopStart_ += renderTick_ + HALF_STEP_TICKS;
+    renderTick_ = -HALF_STEP_TICKS;
+    pendingTick_ = NOT_RENDERED;  // in case the track was just shortened
+    if (resync) {
+      scheduleResync(renderResyncTick_);
+    }
+
+    applySeed(seedLocked_.load());
+    fillOrder(false);
+  }
+}
+
+template <typename Config>
+void BasicTrack<Config>::applySeed(bool restart) {
+  uint32_t seed = seed_.load();
+  if (restart || seed != rngSeed_) {
+    rngSeed_ = seed;
+    reseed();
+  }
+}
+
+template <typename Config>
+void BasicTrack<Config>::fillOrder(bool restart) {
+  previousOrder_ = order_;
+  previousDirection_ = orderDirection_;
+  previousSwing_ = orderSwing_;
+  orderMode_ = playMode_.load();
+  orderSwing_ = swing_.load();
+  int length = trackLength_;
+  bounceBackward_ =
+      orderMode_ == PlayMode::Bounce && !restart && !bounceBackward_;
+
+  switch (orderMode_) {
+    case PlayMode::Forward:
+      for (int slot = 0; slot < length; ++slot) {
+        order_[slot] = static_cast<OrderIndex>(slot);
+      }
+      break;
+    case PlayMode::Backward:
+      for (int slot = 0; slot < length; ++slot) {
+        order_[slot] = static_cast<OrderIndex>(length - 1 - slot);
+      }
+      break;
+    case PlayMode::Random:
+      // (the upper bits, the lowest bits of the generator are weak)
+      for (int slot = 0; slot < length; ++slot) {
+        order_[slot] = static_cast<OrderIndex>(
+            (static_cast<uint64_t>(rng_.next()) * length) >> 32);
+      }
+      break;
+    case PlayMode::Bounce:
+      for (int slot = 0; slot < length; ++slot) {
+        order_[slot] =
+            static_cast<OrderIndex>(bounceBackward_ ? length - 1 - slot : slot);
+      }
+      break;
+    case PlayMode::Brownian: {
+      // on from the last step played (from step 0 at the start): one step on
+      // half of the time, stay or one step back a quarter of the time each
+      int step = restart ? 0 : walk_;
+      for (int slot = 0; slot < length; ++slot) {
+        if (slot > 0 || !restart) {
+          static constexpr int moves[] = {1, 1, 0, -1};
+          step = (step + moves[rng_.next() >> 30] + length) % length;
+        }
+        order_[slot] = static_cast<OrderIndex>(step);
+      }
+      break;
+    }
+  }
+  walk_ = order_[length - 1];
+
+  switch (orderMode_) {
+    case PlayMode::Forward:
+      orderDirection_ = Direction::Forward;
+      break;
+    case PlayMode::Backward:
+      orderDirection_ = Direction::Backward;
+      break;
+    case PlayMode::Bounce:
+      orderDirection_ =
+          bounceBackward_ ? Direction::Backward : Direction::Forward;
+      break;
+    case PlayMode::Random:
+    case PlayMode::Brownian:
+      orderDirection_ = Direction::Drawn;
+      break;
+  }
+}
+
+// {edited} steps the render position went past: take back what they
+// rendered and render them again, unless the play position reached them
+// (steps being rendered right now are left alone, as without lookahead)
+// note: alternate and probability of such a step are drawn again
+template <typename Config>
+void BasicTrack<Config>::rerenderEditedSteps(
+    const StepMask<maxLength>& edited) {
+  // the slots of an edited step that the render position went past as a
+  // whole, in the loop before and in its own loop (in the play order of
+  // each, a step may be in any number of slots)
+  for (bool previous : {true, false}) {
+    juce::int64 loop_start = previous ? previousLoopStart_ : loopStart_;
+    juce::int64 rendered_until =
+        previous ? loopStart_ - HALF_STEP_TICKS : loopStart_ + renderTick_;
+    const Order& order = previous ? previousOrder_ : order_;
+    for (int slot = 0; slot < maxLength; ++slot) {
+      juce::int64 slot_start = loop_start + slot * ticksPerStep;
+      if (slot_start + HALF_STEP_TICKS > rendered_until) {
+        break;  // not rendered ahead
+      }
+      int index = order[slot];
+      if (!edited.test(index)) {
+        continue;
+      }
+      if (slot_start - HALF_STEP_TICKS < getSendTick() + getSendAhead()) {
+        continue;  // (partly) sent already
+      }
+
+      events_.removeTagged(slot_start);
+      if (this->enabled_ && renderTicks_[index] != NOT_RENDERED) {
+        setRenderSlot(loop_start, slot, index, previous);
+        renderStep(index);
+        while (pendingTick_ != NOT_RENDERED) {
+          renderPending(pendingTick_);
+        }
+      }
+    }
+  }
+}
+
+template class BasicTrack<DefaultConfig>;
+template class BasicTrack<EmbeddedConfig>;
+template class BasicTrack<DesktopConfig>;
+
 }  // namespace Sequencer
\ No newline at end of file
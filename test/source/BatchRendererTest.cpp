@@ -0,0 +1,104 @@
+#include <E3Seq/BatchRenderer.h>
+#include <gtest/gtest.h>
+#include <utility>
+
+namespace audio_plugin_test {
+
+// a folder of presets in the temp directory, removed again afterwards
+struct PresetFolder {
+  PresetFolder()
+      : root(juce::File::getSpecialLocation(juce::File::tempDirectory)
+                 .getNonexistentChildFile("E3SeqBatchRendererTest", "")),
+        presets(root.getChildFile("presets")),
+        output(root.getChildFile("output")) {
+    presets.createDirectory();
+  }
+  ~PresetFolder() { root.deleteRecursively(); }
+
+  // every step of track 1 enabled at {probability}, as saved by savePreset()
+  void addPreset(const juce::String& name, float probability) const {
+    juce::XmlElement xml("E3Seq");
+    for (int step = 0; step < STEP_SEQ_DEFAULT_LENGTH; ++step) {
+      juce::String prefix = "T0_S" + juce::String(step) + "_";
+      for (auto [id, value] : {std::pair{"ENABLED", 1.f},
+                               std::pair{"PROBABILITY", probability}}) {
+        auto* param = xml.createNewChildElement("PARAM");
+        param->setAttribute("id", prefix + id);
+        param->setAttribute("value", value);
+      }
+    }
+    xml.writeTo(presets.getChildFile(name + ".xml"));
+  }
+
+  juce::MemoryBlock readOutput(const juce::String& name) const {
+    juce::MemoryBlock data;
+    output.getChildFile(name).loadFileAsData(data);
+    return data;
+  }
+
+  juce::File root, presets, output;
+};
+
+TEST(BatchRenderer, OneFilePerPresetAndSeed) {
+  PresetFolder folder;
+  folder.addPreset("a", 1.f);
+  folder.addPreset("b", 1.f);
+
+  Sequencer::BatchRenderer::Options options;
+  options.seedsPerPreset = 3;
+  options.baseSeed = 10;
+  auto report =
+      Sequencer::BatchRenderer::run(folder.presets, folder.output, options);
+
+  EXPECT_EQ(report.numPresets, 2);
+  EXPECT_EQ(report.numFilesWritten, 6);
+  EXPECT_TRUE(report.failures.isEmpty());
+  for (auto name : {"a", "b"}) {
+    for (int seed = 10; seed < 13; ++seed) {
+      EXPECT_TRUE(folder.output
+                      .getChildFile(juce::String(name) + "_seed" +
+                                    juce::String(seed) + ".mid")
+                      .existsAsFile());
+    }
+  }
+  EXPECT_GE(report.numEvents, 6 * STEP_SEQ_DEFAULT_LENGTH);
+}
+
+TEST(BatchRenderer, SeedIsAppliedPerJob) {
+  PresetFolder folder;
+  folder.addPreset("half", 0.5f);
+
+  Sequencer::BatchRenderer::Options options;
+  options.seedsPerPreset = 2;
+  options.numLoops = 4;
+  Sequencer::BatchRenderer::run(folder.presets, folder.output, options);
+  auto seed0 = folder.readOutput("half_seed0.mid");
+  auto seed1 = folder.readOutput("half_seed1.mid");
+  EXPECT_GT(seed0.getSize(), 0u);
+  EXPECT_NE(seed0, seed1);
+
+  // the same seed renders the same file again, on any number of threads
+  options.numThreads = 1;
+  Sequencer::BatchRenderer::run(folder.presets, folder.output, options);
+  EXPECT_EQ(folder.readOutput("half_seed0.mid"), seed0);
+  EXPECT_EQ(folder.readOutput("half_seed1.mid"), seed1);
+}
+
+TEST(BatchRenderer, FailingPresetsAreReported) {
+  PresetFolder folder;
+  folder.addPreset("good", 1.f);
+  folder.presets.getChildFile("broken.xml").replaceWithText("<E3Seq");
+  folder.presets.getChildFile("other.xml").replaceWithText("<Other/>");
+
+  auto report = Sequencer::BatchRenderer::run(
+      folder.presets, folder.output, Sequencer::BatchRenderer::Options{});
+
+  EXPECT_EQ(report.numPresets, 3);
+  EXPECT_EQ(report.numFilesWritten, 1);
+  ASSERT_EQ(report.failures.size(), 2);
+  EXPECT_TRUE(report.failures[0].startsWith("broken.xml: "));
+  EXPECT_TRUE(report.failures[1].startsWith("other.xml: "));
+  EXPECT_TRUE(folder.output.getChildFile("good_seed0.mid").existsAsFile());
+}
+
+}  // namespace audio_plugin_test
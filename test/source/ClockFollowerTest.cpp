@@ -0,0 +1,126 @@
+#include <E3Seq/ClockFollower.h>
+#include <E3Seq/OfflineRenderer.h>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace audio_plugin_test {
+
+// pulses of a {bpm} clock, each off by up to {jitter} seconds
+static std::vector<double> makeClock(double bpm, int pulses, double jitter) {
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> noise(-jitter, jitter);
+  double period = 60.0 / bpm / Sequencer::ClockFollower::PULSES_PER_QUARTER;
+  std::vector<double> times;
+  for (int i = 0; i < pulses; ++i) {
+    times.push_back(10.0 + i * period + noise(generator));
+  }
+  return times;
+}
+
+TEST(ClockFollower, LocksOntoAJitteryClock) {
+  Sequencer::ClockFollower clock;
+  // 8 bars at 120 BPM, each pulse off by up to 1 ms (a fifth of a pulse)
+  for (double time : makeClock(120.0, 8 * 4 * 24, 0.001)) {
+    clock.pulse(time);
+  }
+
+  EXPECT_TRUE(clock.isLocked());
+  EXPECT_GT(clock.getLockTime(), 0.0);
+  EXPECT_LT(clock.getLockTime(), 2.0);
+  EXPECT_NEAR(clock.getBpm(), 120.0, 0.5);
+  EXPECT_LT(std::abs(clock.getPhaseError()), 0.0015);
+}
+
+TEST(ClockFollower, FollowsTempoChanges) {
+  Sequencer::ClockFollower clock;
+  double time = 0.0;
+  for (double bpm : {100.0, 140.0}) {
+    double period = 60.0 / bpm / Sequencer::ClockFollower::PULSES_PER_QUARTER;
+    for (int i = 0; i < 4 * 4 * 24; ++i) {
+      clock.pulse(time);
+      time += period;
+    }
+    EXPECT_NEAR(clock.getBpm(), bpm, 0.1);
+    EXPECT_TRUE(clock.isLocked());
+  }
+}
+
+TEST(ClockFollower, PulsesDriveTheTicks) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  sequencer.setSyncToMidiClock(true);
+  sequencer.start(1.0);
+
+  // a 150 BPM clock, the sequencer processed every millisecond
+  double period = 60.0 / 150.0 / Sequencer::ClockFollower::PULSES_PER_QUARTER;
+  double next_pulse = 1.0;
+  int pulses = 0;
+  for (double time = 1.0; pulses < 6 * 16; time += 0.001) {
+    if (time >= next_pulse) {
+      sequencer.handleMidiClock(next_pulse);
+      next_pulse += period;
+      ++pulses;
+      // every pulse before this one has played all its ticks, and none
+      // more
+      int tick = (pulses - 1) * sequencer.ticksPerClock;
+      EXPECT_EQ(sequencer.getMonoTrack(0).getCurrentStepIndex(),
+                (tick + TICKS_PER_STEP / 2) / TICKS_PER_STEP %
+                    STEP_SEQ_DEFAULT_LENGTH);
+    }
+    sequencer.process(0.001);
+  }
+  EXPECT_NEAR(sequencer.getBpm(), 150.0, 0.5);
+}
+
+TEST(ClockFollower, ClockOutputSharesTheNoteTimeline) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  std::vector<juce::MidiMessage> sent;
+  auto capture = [&sent](juce::MidiMessage msg) { sent.push_back(msg); };
+  sequencer.sendClockMessage = capture;
+  sequencer.getTrackByChannel(1).sendMidiMessage = capture;
+  sequencer.setSendMidiClock(true);
+
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  sequencer.getMonoTrack(0).setStepAtIndex(4, step);
+
+  constexpr int TICKS = TICKS_PER_STEP * 8;
+  sequencer.start(0.0);
+  for (int i = 0; i < TICKS; ++i) {
+    sequencer.tick();
+  }
+  sequencer.stop();
+  sequencer.rewind();
+  sequencer.resume();
+
+  ASSERT_GE(sent.size(), 4u);
+  EXPECT_TRUE(sent.front().isMidiStart());
+
+  // the clock is exact, following it back measures no jitter at all
+  Sequencer::ClockFollower follower;
+  int clocks = 0;
+  for (const auto& msg : sent) {
+    if (msg.isMidiClock()) {
+      EXPECT_EQ(msg.getTimeStamp(), clocks * sequencer.ticksPerClock);
+      follower.pulse(msg.getTimeStamp() * sequencer.getOneTickTime());
+      ++clocks;
+    } else if (msg.isNoteOn()) {
+      // on the pulse of its step
+      EXPECT_EQ(msg.getTimeStamp(), 4 * TICKS_PER_STEP);
+    }
+  }
+  EXPECT_EQ(clocks, TICKS / sequencer.ticksPerClock);
+  EXPECT_TRUE(follower.isLocked());
+  EXPECT_NEAR(follower.getPhaseError(), 0.0, 1e-9);
+
+  // stopped where it got to, then rewound and continued from the start
+  auto stop = sent.end() - 3;
+  EXPECT_TRUE(stop->isMidiStop());
+  EXPECT_EQ(stop->getTimeStamp(), TICKS);
+  EXPECT_TRUE(stop[1].isSongPositionPointer());
+  EXPECT_EQ(stop[1].getSongPositionPointerMidiBeat(), 0);
+  EXPECT_TRUE(stop[2].isMidiContinue());
+}
+
+}  // namespace audio_plugin_test
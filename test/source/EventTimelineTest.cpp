@@ -0,0 +1,77 @@
+#include <E3Seq/EventTimeline.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace audio_plugin_test {
+
+using Sequencer::EventTimeline;
+
+static juce::MidiMessage noteOn(int number) {
+  return juce::MidiMessage::noteOn(1, number, (juce::uint8)100);
+}
+
+// the note numbers handed out by popDue() from tick 0 to {lastTick}
+static std::vector<int> popAll(EventTimeline& timeline, juce::int64 lastTick) {
+  std::vector<int> notes;
+  for (juce::int64 tick = 0; tick <= lastTick; ++tick) {
+    timeline.popDue(tick, [&](const juce::MidiMessage& message) {
+      EXPECT_EQ(message.getTimeStamp(), static_cast<double>(tick));
+      notes.push_back(message.getNoteNumber());
+    });
+  }
+  return notes;
+}
+
+TEST(EventTimeline, EventsComeOutInTickOrder) {
+  EventTimeline timeline;
+  // further ahead than the wheel, in the same list as tick 10
+  timeline.add(noteOn(4), 10 + 256, 0, 0);
+  timeline.add(noteOn(2), 10, 0, 0);
+  timeline.add(noteOn(3), 10, 0, 0);  // same tick: after the one before
+  timeline.add(noteOn(1), 5, 0, 0);
+
+  EXPECT_EQ(popAll(timeline, 300), (std::vector<int>{1, 2, 3, 4}));
+  EXPECT_EQ(timeline.getNumPending(), 0);
+}
+
+TEST(EventTimeline, LateEventsAreStillSent) {
+  EventTimeline timeline;
+  timeline.popDue(8, [](const juce::MidiMessage&) {});
+
+  timeline.add(noteOn(1), 3, 0, 8);  // moved to now
+  timeline.add(noteOn(2), 7, 0, 6);  // handed out already, read position at 6
+  std::vector<int> notes;
+  timeline.popDue(8, [&](const juce::MidiMessage& message) {
+    notes.push_back(message.getNoteNumber());
+  });
+  EXPECT_EQ(notes, (std::vector<int>{2, 1}));
+}
+
+TEST(EventTimeline, TaggedEventsAreTakenBack) {
+  EventTimeline timeline;
+  timeline.add(noteOn(1), 4, 1, 0);
+  timeline.add(noteOn(2), 4, 2, 0);
+  timeline.add(juce::MidiMessage::noteOff(1, 3), 40, 2, 0);
+  timeline.add(juce::MidiMessage::noteOff(1, 3), 20, 3, 0);
+
+  EXPECT_EQ(timeline.removeNoteOffs(3, 30), EventTimeline::Tag{2});
+  EXPECT_EQ(timeline.removeNoteOffs(3, 30), std::nullopt);
+  timeline.removeTagged(1);
+  EXPECT_EQ(timeline.getNumPending(), 2);
+}
+
+TEST(EventTimeline, FullTimelineRefusesEvents) {
+  EventTimeline timeline;
+  for (int i = 0; i < EventTimeline::CAPACITY; ++i) {
+    ASSERT_TRUE(timeline.add(noteOn(1), i, 0, 0));
+  }
+  EXPECT_EQ(timeline.getNumFree(), 0);
+  EXPECT_FALSE(timeline.add(noteOn(2), 0, 0, 0));
+
+  // handing events out makes room again
+  timeline.popDue(0, [](const juce::MidiMessage&) {});
+  EXPECT_TRUE(timeline.add(noteOn(2), 1, 0, 0));
+  EXPECT_EQ(timeline.getNumPending(), EventTimeline::CAPACITY);
+}
+
+}  // namespace audio_plugin_test
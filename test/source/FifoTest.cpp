@@ -0,0 +1,45 @@
+#include <E3Seq/Fifo.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace audio_plugin_test {
+
+TEST(Fifo, DropsWhatDoesNotFit) {
+  Sequencer::Fifo<int, 4> fifo;
+  EXPECT_TRUE(fifo.push(1));
+  EXPECT_TRUE(fifo.push(2));
+  EXPECT_TRUE(fifo.push(3));
+  EXPECT_FALSE(fifo.push(4));
+  EXPECT_EQ(fifo.getNumReady(), 3);
+
+  int value;
+  for (int expected : {1, 2, 3}) {
+    ASSERT_TRUE(fifo.pop(value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(fifo.pop(value));
+}
+
+TEST(Fifo, KeepsTheOrderAcrossThreads) {
+  Sequencer::Fifo<int, 16> fifo;
+  constexpr int COUNT = 100000;
+  std::thread writer([&fifo] {
+    for (int i = 0; i < COUNT; ++i) {
+      while (!fifo.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  while (expected < COUNT) {
+    int value;
+    if (fifo.pop(value)) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    }
+  }
+  writer.join();
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,84 @@
+#include <E3Seq/InputClock.h>
+#include <E3Seq/OfflineRenderer.h>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace audio_plugin_test {
+
+TEST(InputClock, JitteryCallbacksGiveSteadyTimes) {
+  // 512 sample blocks at 48 kHz, each callback off by up to 2 ms
+  constexpr int BLOCK = 512;
+  constexpr double SAMPLE_RATE = 48000.0;
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> jitter(-0.002, 0.002);
+
+  Sequencer::InputClock clock;
+  double block_end = 3.0;
+  for (int block = 0; block < 2000; ++block) {
+    block_end += BLOCK / SAMPLE_RATE;
+    clock.beginBlock(block_end + jitter(generator), BLOCK, SAMPLE_RATE);
+  }
+
+  // well below the jitter, and below the ms the old stamps were off by
+  double block_start = block_end - BLOCK / SAMPLE_RATE;
+  EXPECT_NEAR(clock.getTime(0), block_start, 0.0005);
+  EXPECT_NEAR(clock.getTime(BLOCK / 2), block_start + 0.5 * BLOCK / SAMPLE_RATE,
+              0.0005);
+}
+
+TEST(InputClock, LatencyIsTakenOff) {
+  Sequencer::InputClock clock;
+  clock.beginBlock(1.0, 480, 48000.0);
+  EXPECT_DOUBLE_EQ(clock.getTime(240), 0.995);
+
+  clock.setLatency(0.004);
+  EXPECT_DOUBLE_EQ(clock.getTime(240), 0.991);
+
+  // a dropout starts the count over at the callback
+  clock.beginBlock(2.0, 480, 48000.0);
+  EXPECT_DOUBLE_EQ(clock.getTime(480), 1.996);
+}
+
+TEST(InputClock, NotesAreRecordedAtTheirTicks) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  sequencer.setArmed(true);
+  sequencer.setQuantizeRec(false);
+  sequencer.start(2.0);
+  for (int i = 0; i < 10 * TICKS_PER_STEP; ++i) {
+    sequencer.tick();
+  }
+  std::vector<std::pair<int, Sequencer::MonoStep>> recorded;
+  sequencer.notifyProcessorMonoStepUpdate =
+      [&recorded](int, int step_index, Sequencer::MonoStep step) {
+        recorded.emplace_back(step_index, step);
+      };
+
+  // the input clock tells when, the play position which tick that was
+  double tick_time = sequencer.getOneTickTime();
+  EXPECT_NEAR(sequencer.getTickAtTime(2.0 + 37.5 * tick_time), 37.5, 1e-9);
+
+  auto note = [](bool on, double tick) {
+    auto message = on ? juce::MidiMessage::noteOn(1, 60, 0.8f)
+                      : juce::MidiMessage::noteOff(1, 60);
+    message.setTimeStamp(tick);
+    return message;
+  };
+  // a little after step 5, and a little before step 7 (already played)
+  sequencer.handleNoteOn(note(true, 5 * TICKS_PER_STEP + 3.2));
+  sequencer.handleNoteOff(note(false, 6 * TICKS_PER_STEP + 3.2));
+  sequencer.handleNoteOn(note(true, 7 * TICKS_PER_STEP - 4.0));
+  sequencer.handleNoteOff(note(false, 9 * TICKS_PER_STEP - 4.0));
+
+  // merged by the sequencer thread, not where the notes came in
+  EXPECT_TRUE(recorded.empty());
+  sequencer.process(0.0);
+
+  ASSERT_EQ(recorded.size(), 2u);
+  EXPECT_EQ(recorded[0].first, 5);
+  EXPECT_EQ(recorded[0].second.note.offset_ticks, 3);
+  EXPECT_EQ(recorded[1].first, 7);
+  EXPECT_EQ(recorded[1].second.note.offset_ticks, -4);
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,535 @@
+#include <E3Seq/OfflineRenderer.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+namespace audio_plugin_test {
+
+static void programHalfProbabilityPattern(Sequencer::OfflineRenderer& r) {
+  for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    Sequencer::MonoStep step;
+    step.enabled = true;
+    step.probability = 0.5f;
+    r.getSequencer().getMonoTrack(0).setStepAtIndex(i, step);
+  }
+}
+
+TEST(OfflineRenderer, EmptyPatternRendersNothing) {
+  Sequencer::OfflineRenderer renderer;
+  EXPECT_EQ(renderer.renderLoops(2).getNumEvents(), 0);
+}
+
+TEST(OfflineRenderer, SameSeedGivesSameResult) {
+  Sequencer::OfflineRenderer first, second;
+  programHalfProbabilityPattern(first);
+  programHalfProbabilityPattern(second);
+  first.setSeed(42);
+  second.setSeed(42);
+
+  auto a = first.renderLoops(8);
+  auto b = second.renderLoops(8);
+
+  ASSERT_EQ(a.getNumEvents(), b.getNumEvents());
+  for (int i = 0; i < a.getNumEvents(); ++i) {
+    EXPECT_EQ(a.getEventPointer(i)->message.getTimeStamp(),
+              b.getEventPointer(i)->message.getTimeStamp());
+    EXPECT_EQ(a.getEventPointer(i)->message.getNoteNumber(),
+              b.getEventPointer(i)->message.getNoteNumber());
+  }
+}
+
+TEST(OfflineRenderer, NoteOnsLandOnTheStepGrid) {
+  Sequencer::OfflineRenderer renderer;
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  renderer.getSequencer().getMonoTrack(0).setStepAtIndex(4, step);
+
+  auto sequence = renderer.renderLoops(2);
+  std::vector<double> note_ons;
+  for (int i = 0; i < sequence.getNumEvents(); ++i) {
+    if (sequence.getEventPointer(i)->message.isNoteOn())
+      note_ons.push_back(sequence.getEventPointer(i)->message.getTimeStamp());
+  }
+
+  ASSERT_EQ(note_ons.size(), 2u);
+  EXPECT_EQ(note_ons[0], 4 * TICKS_PER_STEP);
+  EXPECT_EQ(note_ons[1], (4 + STEP_SEQ_DEFAULT_LENGTH) * TICKS_PER_STEP);
+}
+
+TEST(OfflineRenderer, MicroTimingIsExactInTicks) {
+  using Config = Sequencer::DefaultConfig;
+  Sequencer::OfflineRenderer renderer;
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  step.note.offset_ticks = Config::offsetToTicks(-0.25f);
+  step.note.length_ticks = Config::lengthToTicks(0.5f);
+  renderer.getSequencer().getMonoTrack(0).setStepAtIndex(4, step);
+
+  auto sequence = renderer.renderLoops(1);
+  ASSERT_EQ(sequence.getNumEvents(), 2);
+  EXPECT_EQ(sequence.getEventPointer(0)->message.getTimeStamp(),
+            4 * TICKS_PER_STEP - TICKS_PER_STEP / 4);
+  EXPECT_EQ(sequence.getEventPointer(1)->message.getTimeStamp(),
+            4 * TICKS_PER_STEP + TICKS_PER_STEP / 4);
+}
+
+TEST(OfflineRenderer, OffsetsStayInsideTheirStep) {
+  using Config = Sequencer::DefaultConfig;
+  EXPECT_EQ(Config::offsetToTicks(-0.5f), -TICKS_PER_STEP / 2);
+  EXPECT_EQ(Config::offsetToTicks(0.49f), TICKS_PER_STEP / 2 - 1);
+  EXPECT_EQ(Config::offsetToTicks(0.5f), TICKS_PER_STEP / 2 - 1);
+  // same rounding on both sides of zero
+  EXPECT_EQ(Config::offsetToTicks(1.f / TICKS_PER_STEP), 1);
+  EXPECT_EQ(Config::offsetToTicks(-1.f / TICKS_PER_STEP), -1);
+  EXPECT_EQ(Config::lengthToTicks(0.f), 1);
+}
+
+TEST(OfflineRenderer, EditedStepsAreRescheduled) {
+  Sequencer::OfflineRenderer renderer;
+  auto& track = renderer.getSequencer().getPolyTrack(0);
+  Sequencer::PolyStep step;
+  step.enabled = true;
+  step.notes[0].number = 60;
+  track.setStepAtIndex(2, step);
+  EXPECT_EQ(track.getStepRenderTick(2), 2 * TICKS_PER_STEP);
+
+  // the earliest note decides when the whole step is rendered
+  step.notes[1].number = 64;
+  step.notes[1].offset_ticks = -TICKS_PER_STEP / 4;
+  track.setStepAtIndex(2, step);
+  EXPECT_EQ(track.getStepRenderTick(2),
+            2 * TICKS_PER_STEP - TICKS_PER_STEP / 4);
+
+  step.enabled = false;
+  track.setStepAtIndex(2, step);
+  EXPECT_EQ(track.getStepRenderTick(2), Sequencer::PolyTrack::NOT_RENDERED);
+  EXPECT_EQ(renderer.renderLoops(1).getNumEvents(), 0);
+}
+
+TEST(OfflineRenderer, StealingTheFirstNoteRendersTheStepOnce) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  sequencer.setEnableSmartOverdub(true);
+  auto& track = sequencer.getPolyTrack(0);
+  Sequencer::PolyStep step;
+  step.enabled = true;
+  step.notes[0].number = 60;
+  step.notes[1].number = 64;
+  step.notes[1].offset_ticks = TICKS_PER_STEP / 4;
+  track.setStepAtIndex(2, step);
+
+  std::vector<juce::MidiMessage> sent;
+  track.sendMidiMessage = [&sent](juce::MidiMessage msg) {
+    sent.push_back(msg);
+  };
+  sequencer.start(0.0);
+  // 60 is held, and steals the first note of the chord when step 2 renders
+  auto key = juce::MidiMessage::noteOn(track.getChannel(), 60, 0.8f);
+  key.setTimeStamp(0.0);
+  sequencer.handleNoteOn(key);
+  sequencer.process(0.0);
+  for (int tick = 0; tick < 4 * TICKS_PER_STEP; ++tick) {
+    sequencer.tick();
+  }
+
+  // the step now starts later, but the key stole only once
+  auto played = track.getStepAtIndex(2);
+  EXPECT_EQ(played.notes[0].number, 64);
+  EXPECT_EQ(std::count_if(std::begin(played.notes), std::end(played.notes),
+                          [](const auto& note) {
+                            return note.number == STOLEN_NOTE;
+                          }),
+            1);
+  EXPECT_EQ(track.getStepRenderTick(2),
+            2 * TICKS_PER_STEP + TICKS_PER_STEP / 4);
+  ASSERT_FALSE(sent.empty());
+  EXPECT_EQ(std::count_if(sent.begin(), sent.end(),
+                          [](const auto& msg) { return msg.isNoteOn(); }),
+            1);
+  EXPECT_EQ(sent[0].getNoteNumber(), 64);
+  EXPECT_EQ(sent[0].getTimeStamp(), 2 * TICKS_PER_STEP + TICKS_PER_STEP / 4);
+}
+
+TEST(OfflineRenderer, NoteOffSurvivesShorteningTheTrack) {
+  Sequencer::OfflineRenderer renderer;
+  auto& track = renderer.getSequencer().getPolyTrack(0);
+  Sequencer::PolyStep step;
+  step.enabled = true;
+  step.notes[0].number = 60;
+  step.notes[0].length_ticks = 3 * TICKS_PER_STEP;
+  track.setStepAtIndex(12, step);
+
+  std::vector<juce::MidiMessage> sent;
+  track.sendMidiMessage = [&sent](juce::MidiMessage msg) {
+    sent.push_back(msg);
+  };
+  track.returnToStart();
+  for (int tick = 0; tick < 20 * TICKS_PER_STEP; ++tick) {
+    if (tick == 13 * TICKS_PER_STEP) {
+      track.setLength(14);  // the loop wraps before the note ends
+    }
+    track.tick();
+  }
+
+  ASSERT_EQ(sent.size(), 2u);
+  EXPECT_TRUE(sent[1].isNoteOff());
+  EXPECT_EQ(sent[1].getTimeStamp(), 15 * TICKS_PER_STEP);
+}
+
+TEST(OfflineRenderer, StepsRenderedAheadFollowEdits) {
+  Sequencer::OfflineRenderer renderer;
+  renderer.getSequencer().setLookahead(2);
+  auto& track = renderer.getSequencer().getMonoTrack(0);
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  step.note.number = 60;
+  track.setStepAtIndex(4, step);
+
+  std::vector<juce::MidiMessage> sent;
+  track.sendMidiMessage = [&sent](juce::MidiMessage msg) {
+    sent.push_back(msg);
+  };
+  track.returnToStart();
+  for (int tick = 0; tick < 8 * TICKS_PER_STEP; ++tick) {
+    if (tick == 3 * TICKS_PER_STEP) {
+      step.note.number = 62;  // step 4 is rendered already
+      track.setStepAtIndex(4, step);
+    }
+    track.tick();
+  }
+
+  ASSERT_EQ(sent.size(), 2u);
+  EXPECT_TRUE(sent[0].isNoteOn());
+  EXPECT_EQ(sent[0].getNoteNumber(), 62);
+  EXPECT_EQ(sent[0].getTimeStamp(), 4 * TICKS_PER_STEP);
+  EXPECT_EQ(sent[1].getNoteNumber(), 62);
+}
+
+TEST(OfflineRenderer, TrackDelaysMoveEventsBothWays) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  sequencer.getMonoTrack(0).setStepAtIndex(4, step);
+  sequencer.getMonoTrack(1).setStepAtIndex(4, step);
+
+  double tick_ms = sequencer.getOneTickTime() * 1000.0;
+  sequencer.setTrackDelay(1, -3 * tick_ms);
+  sequencer.setTrackDelay(2, 2 * tick_ms);
+  EXPECT_EQ(sequencer.getLatency(), 0.0);  // nobody to compensate
+
+  auto sequence = renderer.renderLoops(1);
+  ASSERT_EQ(sequence.getNumEvents(), 4);
+  EXPECT_EQ(sequence.getEventPointer(0)->message.getChannel(), 1);
+  EXPECT_EQ(sequence.getEventPointer(0)->message.getTimeStamp(),
+            4 * TICKS_PER_STEP - 3);
+  EXPECT_EQ(sequence.getEventPointer(1)->message.getChannel(), 2);
+  EXPECT_EQ(sequence.getEventPointer(1)->message.getTimeStamp(),
+            4 * TICKS_PER_STEP + 2);
+
+  // a compensating host delays everything by the earliest track instead
+  // (the tracks take it at the next tick)
+  sequencer.setHostCompensatesLatency(true);
+  EXPECT_NEAR(sequencer.getLatency(), 3 * tick_ms * 0.001, 1e-9);
+  sequencer.tick();
+  EXPECT_EQ(sequencer.getMonoTrack(0).getDelay(), 0);
+  EXPECT_EQ(sequencer.getMonoTrack(1).getDelay(), 5);
+}
+
+TEST(OfflineRenderer, LockedSeedReplaysEveryLoop) {
+  Sequencer::OfflineRenderer renderer;
+  programHalfProbabilityPattern(renderer);
+  renderer.setSeed(7);
+  renderer.getSequencer().getMonoTrack(0).setSeedLocked(true);
+
+  constexpr int loop_ticks = STEP_SEQ_DEFAULT_LENGTH * TICKS_PER_STEP;
+  auto sequence = renderer.renderLoops(4);
+  std::vector<double> loops[4];
+  for (int i = 0; i < sequence.getNumEvents(); ++i) {
+    const auto& message = sequence.getEventPointer(i)->message;
+    if (message.isNoteOn()) {
+      int loop = static_cast<int>(message.getTimeStamp()) / loop_ticks;
+      loops[loop].push_back(message.getTimeStamp() - loop * loop_ticks);
+    }
+  }
+
+  EXPECT_GT(loops[0].size(), 0u);
+  EXPECT_LT(loops[0].size(), static_cast<size_t>(STEP_SEQ_DEFAULT_LENGTH));
+  for (int loop = 1; loop < 4; ++loop) {
+    EXPECT_EQ(loops[0], loops[loop]);
+  }
+}
+
+TEST(OfflineRenderer, HostPositionDrivesThePlayPosition) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  std::vector<juce::MidiMessage> sent;
+  sequencer.getTrackByChannel(1).sendMidiMessage =
+      [&sent](juce::MidiMessage msg) { sent.push_back(msg); };
+  for (int index : {0, 8}) {
+    Sequencer::MonoStep step;
+    step.enabled = true;
+    sequencer.getMonoTrack(0).setStepAtIndex(index, step);
+  }
+
+  // a host looping one bar at 120 BPM in blocks of 10 ms, processed every
+  // millisecond
+  constexpr int BLOCKS_PER_LOOP = 200;
+  sequencer.setSyncToHost(true);
+  double time = 5.0;
+  for (int block = 0; block < 3 * BLOCKS_PER_LOOP; ++block) {
+    double ppq = (block % BLOCKS_PER_LOOP) * 0.02;
+    sequencer.setHostPosition(ppq, time, true);
+    for (int ms = 0; ms < 10; ++ms) {
+      sequencer.process(0.001);
+    }
+    time += 0.01;
+
+    if (block % BLOCKS_PER_LOOP == BLOCKS_PER_LOOP / 2) {
+      // well below a sample at 48 kHz
+      EXPECT_LT(std::abs(sequencer.getHostPhaseError()), 1e-6);
+      EXPECT_EQ(sequencer.getMonoTrack(0).getCurrentStepIndex(), 8);
+    }
+  }
+
+  // every loop of the host plays both steps, on the host's ticks
+  // (the first step of a next loop was sent ahead before the host jumped
+  // back, the output drops it, see OutputQueue.h)
+  int note_ons = 0;
+  for (const auto& msg : sent) {
+    if (msg.isNoteOn() && msg.getTimeStamp() < 16 * TICKS_PER_STEP) {
+      EXPECT_EQ(msg.getTimeStamp(), (note_ons % 2) * 8 * TICKS_PER_STEP);
+      ++note_ons;
+    }
+  }
+  EXPECT_EQ(note_ons, 6);
+
+  sequencer.setHostPosition(0.0, time, false);
+  sequencer.process(0.001);
+  EXPECT_FALSE(sequencer.isRunning());
+}
+
+// note on stamps of track 1 with steps {steps} enabled, over {numTicks}
+// (not the ones sent ahead of the end)
+static std::vector<double> renderNoteOns(Sequencer::OfflineRenderer& renderer,
+                                         std::initializer_list<int> steps,
+                                         int numTicks) {
+  auto& sequencer = renderer.getSequencer();
+  std::vector<double> note_ons;
+  sequencer.getTrackByChannel(1).sendMidiMessage =
+      [&note_ons, numTicks](juce::MidiMessage msg) {
+        if (msg.isNoteOn() && msg.getTimeStamp() < numTicks)
+          note_ons.push_back(msg.getTimeStamp());
+      };
+  for (int index : steps) {
+    Sequencer::MonoStep step;
+    step.enabled = true;
+    sequencer.getMonoTrack(0).setStepAtIndex(index, step);
+  }
+  sequencer.start(0.0);
+  for (int i = 0; i < numTicks; ++i) {
+    sequencer.tick();
+  }
+  return note_ons;
+}
+
+TEST(OfflineRenderer, TracksRunAtTheirOwnSpeed) {
+  constexpr int LOOP = STEP_SEQ_DEFAULT_LENGTH * TICKS_PER_STEP;
+  {
+    Sequencer::OfflineRenderer renderer;
+    renderer.getSequencer().getMonoTrack(0).setSpeed({1, 2});
+    EXPECT_EQ(renderNoteOns(renderer, {0, 4}, 4 * LOOP),
+              (std::vector<double>{0, 192, 768, 960}));
+  }
+  {
+    // two track ticks every three sequencer ticks, on the exact fraction
+    Sequencer::OfflineRenderer renderer;
+    renderer.getSequencer().getMonoTrack(0).setSpeed({2, 3});
+    EXPECT_EQ(renderNoteOns(renderer, {0, 1}, 2 * LOOP),
+              (std::vector<double>{0, 36, 576, 612}));
+  }
+  {
+    Sequencer::OfflineRenderer renderer;
+    renderer.getSequencer().getMonoTrack(0).setSpeed({4, 3});
+    auto note_ons = renderNoteOns(renderer, {0, 1, 2}, LOOP);
+    ASSERT_EQ(note_ons.size(), 6u);
+    EXPECT_DOUBLE_EQ(note_ons[1], 18.0);
+    EXPECT_DOUBLE_EQ(note_ons[2], 36.0);
+    EXPECT_DOUBLE_EQ(note_ons[3], 288.0);
+  }
+}
+
+TEST(OfflineRenderer, ResyncStartsTheTrackOverEveryMasterLoop) {
+  // a 16 step track at 2/3 speed against a master loop of 8 steps: 5 1/3
+  // steps of the track fit, so step 6 never plays
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  sequencer.getMonoTrack(0).setSpeed({2, 3});
+  sequencer.getMonoTrack(0).setSyncMode(Sequencer::Track::SyncMode::MasterLoop);
+  sequencer.setMasterLength(8);
+
+  constexpr int MASTER = 8 * TICKS_PER_STEP;
+  auto note_ons = renderNoteOns(renderer, {0, 4, 6}, 3 * MASTER);
+  EXPECT_EQ(note_ons,
+            (std::vector<double>{0, 144, MASTER, MASTER + 144, 2 * MASTER,
+                                 2 * MASTER + 144}));
+
+  // a jump lands in the master loop, not in the track's own loop
+  std::vector<double> after_jump;
+  sequencer.getTrackByChannel(1).sendMidiMessage =
+      [&after_jump](juce::MidiMessage msg) {
+        if (msg.isNoteOn() && msg.getTimeStamp() < 12 * MASTER)
+          after_jump.push_back(msg.getTimeStamp());
+      };
+  sequencer.locate(10 * MASTER + 100);
+  for (int i = 0; i < 2 * MASTER - 100; ++i) {
+    sequencer.tick();
+  }
+  EXPECT_EQ(after_jump, (std::vector<double>{10 * MASTER + 144, 11 * MASTER,
+                                             11 * MASTER + 144}));
+}
+
+TEST(OfflineRenderer, PlayModesReorderTheSteps) {
+  constexpr int LOOP = STEP_SEQ_DEFAULT_LENGTH * TICKS_PER_STEP;
+  {
+    // step {s} plays in slot 15 - s
+    Sequencer::OfflineRenderer renderer;
+    auto& track = renderer.getSequencer().getMonoTrack(0);
+    track.setPlayMode(Sequencer::Track::PlayMode::Backward);
+    EXPECT_EQ(renderNoteOns(renderer, {0, 4}, 2 * LOOP + 2 * TICKS_PER_STEP),
+              (std::vector<double>{264, 360, LOOP + 264, LOOP + 360}));
+    EXPECT_EQ(track.getCurrentStepIndex(), 13);
+  }
+  {
+    Sequencer::OfflineRenderer renderer;
+    renderer.getSequencer().getMonoTrack(0).setPlayMode(
+        Sequencer::Track::PlayMode::Bounce);
+    EXPECT_EQ(renderNoteOns(renderer, {0, 4}, 3 * LOOP),
+              (std::vector<double>{0, 96, LOOP + 264, LOOP + 360, 2 * LOOP,
+                                   2 * LOOP + 96}));
+  }
+}
+
+TEST(OfflineRenderer, MonoNotesEndAtTheNextStepInPlayOrder) {
+  using PlayMode = Sequencer::Track::PlayMode;
+  constexpr int LOOP = STEP_SEQ_DEFAULT_LENGTH * TICKS_PER_STEP;
+
+  // notes held for a whole loop over {numTicks}, the note ons and note offs
+  auto render = [](PlayMode mode, std::initializer_list<int> steps,
+                   int numTicks) {
+    Sequencer::OfflineRenderer renderer;
+    auto& sequencer = renderer.getSequencer();
+    std::vector<double> note_ons, note_offs;
+    sequencer.getTrackByChannel(1).sendMidiMessage =
+        [&, numTicks](juce::MidiMessage msg) {
+          if (msg.getTimeStamp() >= numTicks)
+            return;
+          (msg.isNoteOn() ? note_ons : note_offs).push_back(msg.getTimeStamp());
+        };
+    for (int index : steps) {
+      Sequencer::MonoStep step;
+      step.enabled = true;
+      step.note.length_ticks = LOOP;
+      sequencer.getMonoTrack(0).setStepAtIndex(index, step);
+    }
+    sequencer.getMonoTrack(0).setPlayMode(mode);
+    renderer.setSeed(5);
+    sequencer.start(0.0);
+    for (int i = 0; i < numTicks; ++i) {
+      sequencer.tick();
+    }
+    return std::pair{note_ons, note_offs};
+  };
+
+  // step 2 and 5: within the loop, then over into the next one (turned
+  // around for Bounce)
+  auto [forward_ons, forward_offs] = render(PlayMode::Forward, {2, 5}, LOOP);
+  EXPECT_EQ(forward_ons, (std::vector<double>{48, 120}));
+  EXPECT_EQ(forward_offs, (std::vector<double>{120}));
+  auto [backward_ons, backward_offs] =
+      render(PlayMode::Backward, {2, 5}, 2 * LOOP);
+  EXPECT_EQ(backward_offs, (std::vector<double>{312, LOOP + 240, LOOP + 312}));
+  auto [bounce_ons, bounce_offs] = render(PlayMode::Bounce, {2, 5}, 3 * LOOP);
+  EXPECT_EQ(bounce_ons, (std::vector<double>{48, 120, LOOP + 240, LOOP + 312,
+                                             2 * LOOP + 48, 2 * LOOP + 120}));
+  // (the turned around loop plays step 5 late, the note ends at its length)
+  EXPECT_EQ(bounce_offs,
+            (std::vector<double>{120, LOOP + 120, LOOP + 312, 2 * LOOP + 48,
+                                 2 * LOOP + 120}));
+
+  // every step enabled: the next slot, whichever step was drawn for it
+  for (PlayMode mode : {PlayMode::Random, PlayMode::Brownian}) {
+    auto [ons, offs] = render(
+        mode, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        2 * LOOP);
+    ASSERT_EQ(ons.size(), 32u);
+    for (size_t i = 0; i + 1 < ons.size(); ++i) {
+      EXPECT_EQ(offs[i], ons[i + 1]);
+    }
+  }
+}
+
+TEST(OfflineRenderer, LockedSeedReplaysTheRandomOrder) {
+  Sequencer::OfflineRenderer renderer;
+  auto& track = renderer.getSequencer().getMonoTrack(0);
+  for (int i = 0; i < STEP_SEQ_DEFAULT_LENGTH; ++i) {
+    Sequencer::MonoStep step;
+    step.enabled = true;
+    step.note.number = 40 + i;
+    track.setStepAtIndex(i, step);
+  }
+  renderer.setSeed(3);
+  track.setSeedLocked(true);
+  track.setPlayMode(Sequencer::Track::PlayMode::Random);
+
+  constexpr int loop_ticks = STEP_SEQ_DEFAULT_LENGTH * TICKS_PER_STEP;
+  auto sequence = renderer.renderLoops(3);
+  std::vector<int> loops[3];
+  for (int i = 0; i < sequence.getNumEvents(); ++i) {
+    const auto& message = sequence.getEventPointer(i)->message;
+    if (message.isNoteOn()) {
+      int loop = static_cast<int>(message.getTimeStamp()) / loop_ticks;
+      loops[loop].push_back(message.getNoteNumber());
+    }
+  }
+
+  // one note on per slot, not in step order
+  ASSERT_EQ(loops[0].size(), static_cast<size_t>(STEP_SEQ_DEFAULT_LENGTH));
+  EXPECT_FALSE(std::is_sorted(loops[0].begin(), loops[0].end()));
+  for (int loop = 1; loop < 3; ++loop) {
+    EXPECT_EQ(loops[0], loops[loop]);
+  }
+}
+
+TEST(OfflineRenderer, SwingDelaysEveryOtherStep) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  sequencer.setSwing(0.75f);
+  EXPECT_EQ(sequencer.getMonoTrack(0).getSwing(), TICKS_PER_STEP / 2);
+  EXPECT_EQ(renderNoteOns(renderer, {0, 1, 2, 3}, 4 * TICKS_PER_STEP),
+            (std::vector<double>{0, 36, 48, 84}));
+}
+
+TEST(OfflineRenderer, RetriggersStayOnTheStraightGrid) {
+  Sequencer::OfflineRenderer renderer;
+  auto& track = renderer.getSequencer().getMonoTrack(0);
+  track.setSwing(TICKS_PER_STEP / 2);
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  step.retrigger_ticks = 8;
+  step.note.length_ticks = TICKS_PER_STEP;
+  track.setStepAtIndex(1, step);
+
+  std::vector<double> note_ons;
+  track.sendMidiMessage = [&note_ons](juce::MidiMessage msg) {
+    if (msg.isNoteOn())
+      note_ons.push_back(msg.getTimeStamp());
+  };
+  track.returnToStart();
+  for (int tick = 0; tick < 3 * TICKS_PER_STEP; ++tick) {
+    track.tick();
+  }
+  // the note on moves to 36, the retriggers stay at 24 + 8 n
+  EXPECT_EQ(note_ons, (std::vector<double>{36, 40, 48, 56}));
+}
+
+}  // namespace audio_plugin_test
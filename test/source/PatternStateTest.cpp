@@ -0,0 +1,95 @@
+#include <E3Seq/OfflineRenderer.h>
+#include <E3Seq/PatternState.h>
+#include <gtest/gtest.h>
+
+namespace audio_plugin_test {
+
+static Sequencer::MonoStep makeEnabledStep(int note) {
+  Sequencer::MonoStep step;
+  step.enabled = true;
+  step.note.number = note;
+  return step;
+}
+
+TEST(PatternState, OnlyWrittenPagesAreAllocated) {
+  Sequencer::PagedSteps<Sequencer::MonoStep, 16, 256> steps;
+  EXPECT_EQ(steps.getNumAllocatedPages(), 0);
+
+  steps.set(100, Sequencer::MonoStep{});  // default steps are not stored
+  EXPECT_EQ(steps.getNumAllocatedPages(), 0);
+
+  steps.set(200, makeEnabledStep(64));
+  EXPECT_EQ(steps.getNumAllocatedPages(), 1);
+  EXPECT_TRUE(steps[200].enabled);
+  EXPECT_EQ(steps[200].note.number, 64);
+  EXPECT_FALSE(steps[201].enabled);
+  EXPECT_FALSE(steps[5].enabled);
+}
+
+TEST(PatternState, CompactFormatKeepsTheStepRanges) {
+  using Config = Sequencer::DefaultConfig;
+  Sequencer::StepColumns<Sequencer::MonoStep, 16, true> columns;
+  columns.fill(Sequencer::MonoStep{});
+
+  auto step = makeEnabledStep(127);
+  step.note.velocity = 1;
+  step.note.offset_ticks = Config::offsetToTicks(-0.5f);
+  step.note.length_ticks = Config::lengthToTicks(STEP_SEQ_MAX_LENGTH);
+  step.retrigger_ticks = Config::stepsToTicks(1.5f);
+  step.probability = 1.f;
+  step.alternate = 3;
+  columns.set(7, step);
+  EXPECT_TRUE(columns.get(7) == step);
+  EXPECT_TRUE(columns.get(6) == Sequencer::MonoStep{});
+
+  // probability is quantized to 8 bits
+  step.probability = 0.5f;
+  columns.set(7, step);
+  EXPECT_NEAR(columns.getProbability(7), 0.5f, 1.f / 255.f);
+
+  int plays = 0;
+  for (int pass = 0; pass < 9; ++pass) {
+    plays += columns.advanceAlternate(7) ? 1 : 0;
+  }
+  EXPECT_EQ(plays, 3);
+}
+
+TEST(PatternState, LongPatternSurvivesRoundTrip) {
+  Sequencer::OfflineRenderer source, destination;
+  auto& mono = source.getSequencer().getMonoTrack(2);
+  mono.setLength(STEP_SEQ_MAX_LENGTH);
+  mono.setStepAtIndex(0, makeEnabledStep(48));
+  mono.setStepAtIndex(STEP_SEQ_MAX_LENGTH - 1, makeEnabledStep(72));
+
+  Sequencer::PolyStep chord;
+  chord.enabled = true;
+  chord.notes[1].number = 64;
+  source.getSequencer().getPolyTrack(1).setStepAtIndex(130, chord);
+
+  auto pattern = Sequencer::PatternState::write(source.getSequencer());
+  ASSERT_TRUE(
+      Sequencer::PatternState::read(*pattern, destination.getSequencer()));
+
+  auto& sequencer = destination.getSequencer();
+  EXPECT_EQ(sequencer.getMonoTrack(2).getStepAtIndex(0).note.number, 48);
+  EXPECT_EQ(sequencer.getMonoTrack(2)
+                .getStepAtIndex(STEP_SEQ_MAX_LENGTH - 1)
+                .note.number,
+            72);
+  EXPECT_FALSE(sequencer.getMonoTrack(2).getStepAtIndex(1).enabled);
+  EXPECT_TRUE(sequencer.getPolyTrack(1).getStepAtIndex(130) == chord);
+}
+
+TEST(PatternState, StepsPastTheFirstPageArePlayed) {
+  Sequencer::OfflineRenderer renderer;
+  auto& track = renderer.getSequencer().getMonoTrack(0);
+  track.setLength(128);
+  track.setStepAtIndex(100, makeEnabledStep(60));
+
+  auto sequence = renderer.renderLoops(1);
+  ASSERT_EQ(sequence.getNumEvents(), 2);
+  EXPECT_EQ(sequence.getEventPointer(0)->message.getTimeStamp(),
+            100 * TICKS_PER_STEP);
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,72 @@
+#include <E3Seq/Step.h>
+#include <gtest/gtest.h>
+
+namespace audio_plugin_test {
+
+// voice count is a compile-time parameter of the config
+template <int Voices>
+struct VoicesConfig : Sequencer::SequencerConfig<24, 16, Voices, 8, 4> {};
+
+template <typename Step>
+class PolyStepTest : public ::testing::Test {};
+
+template <int Voices>
+using VoicesStep = Sequencer::BasicPolyStep<VoicesConfig<Voices>>;
+
+using VoiceCounts =
+    ::testing::Types<VoicesStep<4>, VoicesStep<8>, VoicesStep<16>>;
+TYPED_TEST_SUITE(PolyStepTest, VoiceCounts);
+
+template <typename Step>
+Step makeChord(std::initializer_list<int> numbers) {
+  Step step;
+  step.enabled = true;
+  int i = 0;
+  for (int number : numbers) {
+    step.notes[i++].number = number;
+  }
+  for (; i < Step::polyphony; ++i) {
+    step.notes[i].number = DISABLED_NOTE;
+  }
+  return step;
+}
+
+TYPED_TEST(PolyStepTest, StealsTheSameNoteFirst) {
+  auto step = makeChord<TypeParam>({60, 64, 67});
+  step.stealNote(64);
+  EXPECT_EQ(step.notes[0].number, 67);
+  EXPECT_EQ(step.notes[1].number, 60);
+  EXPECT_TRUE(step.isSorted());
+}
+
+TYPED_TEST(PolyStepTest, ThenAVacantVoiceThenTheClosestNote) {
+  auto full = TypeParam{};
+  full.enabled = true;
+  for (int i = 0; i < TypeParam::polyphony; ++i) {
+    full.notes[i].number = 100 - i * 4;  // sorted, no vacant voice
+  }
+
+  auto vacant = makeChord<TypeParam>({72, 60});
+  vacant.stealNote(66);
+  EXPECT_EQ(vacant.notes[0].number, 72);
+  EXPECT_EQ(vacant.notes[1].number, 60);
+
+  // 98 is as close to 96 as to 100, the later voice is stolen
+  full.stealNote(98);
+  EXPECT_EQ(full.notes[0].number, 100);
+  EXPECT_EQ(full.notes[TypeParam::polyphony - 1].number, STOLEN_NOTE);
+  EXPECT_TRUE(full.isSorted());
+}
+
+TYPED_TEST(PolyStepTest, AddedNotesKeepTheOrder) {
+  auto step = makeChord<TypeParam>({72, 60});
+  typename TypeParam::Note note;
+  note.number = 65;
+  step.addNote(note);
+  EXPECT_EQ(step.notes[0].number, 72);
+  EXPECT_EQ(step.notes[1].number, 65);
+  EXPECT_EQ(step.notes[2].number, 60);
+  EXPECT_TRUE(step.isSorted());
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,86 @@
+#include <E3Seq/OfflineRenderer.h>
+#include <E3Seq/SharedClock.h>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace audio_plugin_test {
+
+using Role = Sequencer::E3Sequencer::SharedClockRole;
+
+TEST(SharedClock, NothingPublishedYet) {
+  Sequencer::SharedClock clock{};  // (as mapped from a new file)
+  Sequencer::SharedClock::Position position;
+  unsigned version = 0;
+  EXPECT_FALSE(clock.read(position, version));
+
+  clock.publish({96.0, 1.5, 120.0, true});
+  ASSERT_TRUE(clock.read(position, version));
+  EXPECT_EQ(position.tick, 96.0);
+  EXPECT_TRUE(position.playing);
+  EXPECT_FALSE(clock.read(position, version));  // nothing new
+}
+
+TEST(SharedClock, InstancesShareOneTimeline) {
+  // two instances, each on its own jittery 1 ms timer, started apart
+  Sequencer::SharedClock clock{};
+  Sequencer::OfflineRenderer leader_renderer, follower_renderer;
+  auto& leader = leader_renderer.getSequencer();
+  auto& follower = follower_renderer.getSequencer();
+  leader.setSharedClock(&clock, Role::Lead);
+  follower.setSharedClock(&clock, Role::Follow);
+
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<double> jitter(-0.0003, 0.0003);
+  double time = 10.0;
+  leader.start(time);
+  double max_error = 0.0;
+  for (int ms = 0; ms < 4000; ++ms) {
+    if (ms == 2000) {
+      leader.setBpm(133.0);
+    }
+    leader.process(0.001 + jitter(generator));
+    follower.process(0.001 + jitter(generator));
+    time += 0.001;
+
+    // where each instance puts the same moment on the tick timeline
+    if (ms > 10 && (ms < 2000 || ms > 2100)) {
+      double ticks = leader.getTickAtTime(time) - follower.getTickAtTime(time);
+      max_error = std::max(max_error,
+                           std::abs(ticks) * leader.getOneTickTime());
+    }
+  }
+  EXPECT_TRUE(follower.isRunning());
+  EXPECT_EQ(follower.getBpm(), 133.0);
+  // well below a sample at 48 kHz (each running off its own timer, the
+  // instances were a timer period or more apart)
+  EXPECT_LT(max_error, 1e-6);
+  EXPECT_LT(std::abs(follower.getHostPhaseError()), 1e-6);
+
+  leader.stop();
+  leader.process(0.001);  // (published from the leader's tick thread)
+  follower.process(0.001);
+  EXPECT_FALSE(follower.isRunning());
+}
+
+TEST(SharedClock, LeaderPublishesOnItsTickThread) {
+  Sequencer::SharedClock clock{};
+  Sequencer::OfflineRenderer renderer;
+  auto& leader = renderer.getSequencer();
+  leader.setSharedClock(&clock, Role::Lead);
+  leader.start(1.0);
+  leader.process(0.001);
+
+  Sequencer::SharedClock::Position position;
+  unsigned version = 0;
+  ASSERT_TRUE(clock.read(position, version));
+  EXPECT_TRUE(position.playing);
+
+  // stop() (from the editor or the audio thread) leaves it to process()
+  leader.stop();
+  EXPECT_FALSE(clock.read(position, version));
+  leader.process(0.001);
+  ASSERT_TRUE(clock.read(position, version));
+  EXPECT_FALSE(position.playing);
+}
+
+}  // namespace audio_plugin_test
@@ -0,0 +1,61 @@
+#include <E3Seq/StepMask.h>
+#include <gtest/gtest.h>
+
+namespace audio_plugin_test {
+
+using Mask = Sequencer::StepMask<256>;
+
+TEST(StepMask, FindsNextAndPreviousAcrossWords) {
+  Mask mask;
+  EXPECT_FALSE(mask.any());
+  mask.set(3, true);
+  mask.set(70, true);
+  mask.set(255, true);
+  EXPECT_EQ(mask.count(), 3);
+
+  EXPECT_EQ(mask.findNext(4, 256), 70);
+  EXPECT_EQ(mask.findNext(71, 256), 255);
+  EXPECT_EQ(mask.findNext(3, 16), 3);
+  EXPECT_EQ(mask.findNext(71, 200), 3);  // wraps at the track length
+
+  EXPECT_EQ(mask.findPrevious(69, 256), 3);
+  EXPECT_EQ(mask.findPrevious(2, 256), 255);
+  EXPECT_EQ(mask.findPrevious(2, 64), 3);
+}
+
+TEST(StepMask, EmptyMaskFindsNothing) {
+  Mask mask;
+  EXPECT_EQ(mask.findNext(0, 256), -1);
+  EXPECT_EQ(mask.findPrevious(0, 256), -1);
+  EXPECT_EQ(mask.findLast(0, 0), -1);
+}
+
+TEST(StepMask, RotatesWithinTheTrackLength) {
+  Mask mask;
+  mask.set(3, true);
+  mask.set(70, true);
+
+  auto later = mask.rotated(2, 72);
+  EXPECT_TRUE(later.test(5));
+  EXPECT_TRUE(later.test(0));
+  EXPECT_EQ(later.count(), 2);
+
+  auto earlier = mask.rotated(-4, 16);  // step 70 is outside of 16 steps
+  EXPECT_TRUE(earlier.test(15));
+  EXPECT_EQ(earlier.count(), 1);
+}
+
+TEST(StepMask, AtomicMaskIsTakenAtOnce) {
+  Sequencer::AtomicStepMask<256> marked;
+  marked.set(5);
+  Mask enabled;
+  enabled.set(5, true);
+  enabled.set(200, true);
+  marked.add(enabled);
+
+  Mask taken = marked.take();
+  EXPECT_EQ(taken, enabled);
+  EXPECT_FALSE(marked.take().any());
+}
+
+}  // namespace audio_plugin_test
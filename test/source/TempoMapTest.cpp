@@ -0,0 +1,99 @@
+#include <E3Seq/OfflineRenderer.h>
+#include <E3Seq/TempoMap.h>
+#include <gtest/gtest.h>
+
+namespace audio_plugin_test {
+
+// a quarter note is 4 steps
+constexpr int QUARTER = TICKS_PER_STEP * 4;
+
+TEST(TempoMap, ChangesKeepTheTimeOfEarlierTicks) {
+  Sequencer::TempoMap tempo(TICKS_PER_STEP, 120.0);
+  EXPECT_DOUBLE_EQ(tempo.getTime(QUARTER), 0.5);
+
+  tempo.setTempo(QUARTER, 60.0);
+  EXPECT_DOUBLE_EQ(tempo.getTime(QUARTER), 0.5);
+  EXPECT_DOUBLE_EQ(tempo.getTime(2 * QUARTER), 1.5);
+  EXPECT_DOUBLE_EQ(tempo.getTick(1.5), 2 * QUARTER);
+  EXPECT_DOUBLE_EQ(tempo.getBpm(QUARTER - 1), 120.0);
+
+  // a later change replaces what was set after it
+  tempo.setTempo(4 * QUARTER, 90.0);
+  tempo.setTempo(2 * QUARTER, 240.0);
+  EXPECT_EQ(tempo.getNumSegments(), 3);
+  EXPECT_DOUBLE_EQ(tempo.getBpm(4 * QUARTER), 240.0);
+}
+
+TEST(TempoMap, RampsIntegrateTheTempo) {
+  Sequencer::TempoMap tempo(TICKS_PER_STEP, 60.0);
+  constexpr int LENGTH = 8 * QUARTER;
+  tempo.rampTempo(QUARTER, 120.0, LENGTH);
+  EXPECT_DOUBLE_EQ(tempo.getBpm(QUARTER + LENGTH / 2), 90.0);
+  EXPECT_DOUBLE_EQ(tempo.getBpm(QUARTER + 2 * LENGTH), 120.0);
+
+  // the sum of the tick lengths at the tempo of the middle of each tick
+  double time = 1.0;
+  for (int tick = QUARTER; tick < QUARTER + LENGTH; ++tick) {
+    double bpm = 60.0 + 60.0 * (tick - QUARTER + 0.5) / LENGTH;
+    time += 15.0 / bpm / TICKS_PER_STEP;
+  }
+  EXPECT_NEAR(tempo.getTime(QUARTER + LENGTH), time, 1e-6);
+
+  for (double tick : {10.0, 300.5, 700.25, 2000.0}) {
+    EXPECT_NEAR(tempo.getTick(tempo.getTime(tick)), tick, 1e-9);
+  }
+
+  // what lies before the ramp is forgotten, the ramp is still there
+  tempo.forget(2 * QUARTER);
+  EXPECT_EQ(tempo.getNumSegments(), 2);
+  EXPECT_NEAR(tempo.getTime(QUARTER + LENGTH), time, 1e-6);
+}
+
+TEST(TempoMap, SequencerTempoChangesDoNotMoveThePast) {
+  Sequencer::OfflineRenderer renderer;
+  auto& sequencer = renderer.getSequencer();
+  sequencer.start(10.0);
+  for (int i = 0; i < 200; ++i) {
+    sequencer.tick();
+  }
+
+  double played = sequencer.getTickTime(199);
+  sequencer.setBpm(60.0);
+  EXPECT_DOUBLE_EQ(sequencer.getBpm(), 60.0);
+  sequencer.tick();  // the change applies from this tick on
+  EXPECT_DOUBLE_EQ(sequencer.getTickTime(199), played);
+  EXPECT_NEAR(sequencer.getTickTime(300) - sequencer.getTickTime(200),
+              100 * 15.0 / 60.0 / TICKS_PER_STEP, 1e-12);
+
+  // a ramp (from this tick on) speeds the ticks up one by one
+  sequencer.setBpm(120.0, 4.0);
+  sequencer.tick();
+  double previous = sequencer.getOneTickTime();
+  for (int i = 1; i < 4 * TICKS_PER_STEP; ++i) {
+    sequencer.tick();
+    EXPECT_LT(sequencer.getOneTickTime(), previous);
+    previous = sequencer.getOneTickTime();
+  }
+  sequencer.tick();
+  EXPECT_DOUBLE_EQ(sequencer.getOneTickTime(), 15.0 / 120.0 / TICKS_PER_STEP);
+}
+
+TEST(TempoMap, ChangingEveryTickNeverGrows) {
+  // like a tempo following a MIDI clock, a little different every tick
+  Sequencer::TempoMap tempo(TICKS_PER_STEP, 120.0, 8);
+  for (int tick = 1; tick <= 100; ++tick) {
+    tempo.setTempo(tick, 120.0 + (tick % 2) * 0.5);
+    tempo.setTempo(tick, 120.0 + (tick % 2) * 0.5);  // unchanged: nothing
+  }
+  EXPECT_EQ(tempo.getNumSegments(), 8);
+
+  // the oldest changes are gone, the recent ones keep their times
+  double time = tempo.getTime(93.0);
+  for (int tick = 93; tick < 100; ++tick) {
+    time += 15.0 / (120.0 + (tick % 2) * 0.5) / TICKS_PER_STEP;
+  }
+  EXPECT_NEAR(tempo.getTime(100.0), time, 1e-12);
+  EXPECT_DOUBLE_EQ(tempo.getBpm(100.0), 120.0);
+}
+
+}  // namespace audio_plugin_test
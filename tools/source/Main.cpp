@@ -0,0 +1,125 @@
+// headless front end of the sequencer
+// renders presets to Standard MIDI Files without opening the plugin
+
+#include "E3Seq/BatchRenderer.h"
+#include <iostream>
+
+namespace {
+
+// MARK: render command
+void render(const juce::ArgumentList& args) {
+  args.checkMinNumArguments(3);
+  auto preset_file = args[1].resolveAsExistingFile();
+  auto output_file = args[2].resolveAsFile();
+
+  auto xml = juce::XmlDocument::parse(preset_file);
+  if (xml == nullptr)
+    juce::ConsoleApplication::fail("Could not parse " +
+                                   preset_file.getFullPathName());
+
+  double bpm = BPM_DEFAULT;
+  if (args.containsOption("--bpm"))
+    bpm = args.getValueForOption("--bpm").getDoubleValue();
+
+  Sequencer::OfflineRenderer renderer(bpm);
+  if (!renderer.loadPreset(*xml))
+    juce::ConsoleApplication::fail(preset_file.getFullPathName() +
+                                   " is not an E3Seq preset");
+
+  if (args.containsOption("--seed"))
+    renderer.setSeed(args.getValueForOption("--seed").getLargeIntValue());
+
+  auto start_time = juce::Time::getMillisecondCounterHiRes();
+
+  juce::MidiMessageSequence sequence;
+  double rendered_seconds = 0.0;
+  if (args.containsOption("--seconds")) {
+    rendered_seconds = args.getValueForOption("--seconds").getDoubleValue();
+    sequence = renderer.renderDuration(rendered_seconds);
+  } else {
+    int num_loops = 1;
+    if (args.containsOption("--loops"))
+      num_loops = args.getValueForOption("--loops").getIntValue();
+    sequence = renderer.renderLoops(num_loops);
+    rendered_seconds =
+        sequence.getEndTime() * renderer.getSequencer().getOneTickTime();
+  }
+
+  auto elapsed_ms = juce::Time::getMillisecondCounterHiRes() - start_time;
+
+  if (!renderer.writeMidiFile(sequence, output_file))
+    juce::ConsoleApplication::fail("Could not write " +
+                                   output_file.getFullPathName());
+
+  std::cout << "rendered " << sequence.getNumEvents() << " events ("
+            << rendered_seconds << " s) to "
+            << output_file.getFullPathName().toRawUTF8() << " in "
+            << elapsed_ms << " ms" << std::endl;
+}
+
+// MARK: batch command
+void batch(const juce::ArgumentList& args) {
+  args.checkMinNumArguments(3);
+  auto preset_folder = args[1].resolveAsExistingFolder();
+  auto output_folder = args[2].resolveAsFile();
+
+  Sequencer::BatchRenderer::Options options;
+  if (args.containsOption("--seeds"))
+    options.seedsPerPreset = args.getValueForOption("--seeds").getIntValue();
+  if (args.containsOption("--loops"))
+    options.numLoops = args.getValueForOption("--loops").getIntValue();
+  if (args.containsOption("--seed"))
+    options.baseSeed = args.getValueForOption("--seed").getLargeIntValue();
+  if (args.containsOption("--bpm"))
+    options.bpm = args.getValueForOption("--bpm").getDoubleValue();
+  if (args.containsOption("--threads"))
+    options.numThreads = args.getValueForOption("--threads").getIntValue();
+
+  auto report =
+      Sequencer::BatchRenderer::run(preset_folder, output_folder, options);
+
+  for (const auto& failure : report.failures)
+    std::cerr << "failed: " << failure.toRawUTF8() << std::endl;
+
+  std::cout << report.numPresets << " presets, " << report.numFilesWritten
+            << " files, " << report.numEvents << " events in "
+            << report.elapsedSeconds << " s ("
+            << report.getPresetsPerSecond() << " presets/s, "
+            << report.getEventsPerSecond() << " events/s), "
+            << report.failures.size() << " failures" << std::endl;
+
+  if (!report.failures.isEmpty())
+    juce::ConsoleApplication::fail("some presets could not be rendered");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  juce::ConsoleApplication app;
+
+  app.addHelpCommand("--help|-h", "E3Seq headless renderer", true);
+
+  app.addCommand(
+      {"--render",
+       "--render <preset.xml> <output.mid> [--loops=N | --seconds=S] "
+       "[--seed=N] [--bpm=BPM]",
+       "Renders a preset to a Standard MIDI File",
+       "Runs the sequencer tick by tick without a timer. By default one loop "
+       "of the longest track is rendered. Probability is drawn from per-track "
+       "generators derived from --seed, so the same seed always gives the "
+       "same file.",
+       render});
+
+  app.addCommand(
+      {"--batch",
+       "--batch <preset folder> <output folder> [--seeds=M] [--loops=N] "
+       "[--seed=N] [--bpm=BPM] [--threads=T]",
+       "Renders every preset in a folder on all cores",
+       "Each preset (XML or binary plugin state) is rendered with M "
+       "consecutive seeds starting from --seed. Presets are spread over a "
+       "thread pool with one worker per core unless --threads is given. "
+       "Throughput and per-file failures are reported at the end.",
+       batch});
+
+  return app.findAndRunCommand(argc, argv);
+}